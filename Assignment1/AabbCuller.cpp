@@ -0,0 +1,146 @@
+#include "AabbCuller.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RTR_SSE2 1
+#endif
+
+bool AabbCuller::enabled = true;
+size_t AabbCuller::tested = 0;
+size_t AabbCuller::visible = 0;
+
+void AabbCuller::ResetStats() {
+	tested = 0;
+	visible = 0;
+}
+
+void AabbCuller::Transform(const glm::mat4& m, const glm::vec3& aabbMin, const glm::vec3& aabbMax,
+	glm::vec3& center, glm::vec3& extent) {
+	glm::vec3 localCenter = (aabbMin + aabbMax) * 0.5f;
+	glm::vec3 localExtent = (aabbMax - aabbMin) * 0.5f;
+	center = glm::vec3(m * glm::vec4(localCenter, 1.0f));
+	// each world axis gathers the absolute contributions of the local axes (Arvo)
+	glm::mat3 abs(glm::abs(glm::vec3(m[0])), glm::abs(glm::vec3(m[1])), glm::abs(glm::vec3(m[2])));
+	extent = abs * localExtent;
+}
+
+void AabbCuller::Clear() {
+	count = 0;
+	cx.clear(); cy.clear(); cz.clear();
+	ex.clear(); ey.clear(); ez.clear();
+}
+
+size_t AabbCuller::Add(const glm::vec3& aabbMin, const glm::vec3& aabbMax, const glm::mat4& m) {
+	glm::vec3 center, extent;
+	Transform(m, aabbMin, aabbMax, center, extent);
+	// drop the padding of the previous Cull before appending
+	cx.resize(count); cy.resize(count); cz.resize(count);
+	ex.resize(count); ey.resize(count); ez.resize(count);
+	cx.push_back(center.x); cy.push_back(center.y); cz.push_back(center.z);
+	ex.push_back(extent.x); ey.push_back(extent.y); ez.push_back(extent.z);
+	return count++;
+}
+
+bool AabbCuller::testScalar(size_t i, const Frustum& frustum) const {
+	return frustum.IntersectsAABB(glm::vec3(cx[i], cy[i], cz[i]), glm::vec3(ex[i], ey[i], ez[i]));
+}
+
+#ifdef RTR_SSE2
+unsigned int AabbCuller::testSimd(size_t begin, const Frustum& frustum) const {
+	__m128 x = _mm_loadu_ps(&cx[begin]);
+	__m128 y = _mm_loadu_ps(&cy[begin]);
+	__m128 z = _mm_loadu_ps(&cz[begin]);
+	__m128 hx = _mm_loadu_ps(&ex[begin]);
+	__m128 hy = _mm_loadu_ps(&ey[begin]);
+	__m128 hz = _mm_loadu_ps(&ez[begin]);
+	// clears the sign bit
+	__m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+	// inside all six planes: n.c + d >= -|n|.e
+	__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (const glm::vec4& p : frustum.planes) {
+		__m128 nx = _mm_set1_ps(p.x), ny = _mm_set1_ps(p.y), nz = _mm_set1_ps(p.z);
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)),
+			_mm_add_ps(_mm_mul_ps(z, nz), _mm_set1_ps(p.w)));
+		__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, _mm_and_ps(nx, absMask)), _mm_mul_ps(hy, _mm_and_ps(ny, absMask))),
+			_mm_mul_ps(hz, _mm_and_ps(nz, absMask)));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_sub_ps(_mm_setzero_ps(), r)));
+	}
+	return static_cast<unsigned int>(_mm_movemask_ps(inside));
+}
+#else
+unsigned int AabbCuller::testSimd(size_t begin, const Frustum& frustum) const {
+	unsigned int mask = 0;
+	for (size_t k = 0; k < 4; ++k)
+		if (testScalar(begin + k, frustum)) mask |= 1u << k;
+	return mask;
+}
+#endif
+
+void AabbCuller::Cull(const Frustum& frustum, std::vector<unsigned char>& visibleOut, bool simd) {
+	visibleOut.assign(count, 0);
+	size_t drawn = 0;
+	if (simd) {
+		// padding: far away zero size boxes fail the plane tests
+		size_t padded = (count + 3) & ~size_t(3);
+		cx.resize(padded, 1e30f); cy.resize(padded, 1e30f); cz.resize(padded, 1e30f);
+		ex.resize(padded, 0.0f); ey.resize(padded, 0.0f); ez.resize(padded, 0.0f);
+		for (size_t begin = 0; begin < count; begin += 4) {
+			unsigned int mask = testSimd(begin, frustum);
+			for (size_t k = 0; mask && begin + k < count; ++k, mask >>= 1) {
+				if (mask & 1u) {
+					visibleOut[begin + k] = 1;
+					drawn++;
+				}
+			}
+		}
+	}
+	else {
+		for (size_t i = 0; i < count; ++i) {
+			if (testScalar(i, frustum)) {
+				visibleOut[i] = 1;
+				drawn++;
+			}
+		}
+	}
+	tested += count;
+	visible += drawn;
+}
+
+// -------------------- Benchmark --------------------
+
+void AabbCuller::Benchmark(size_t boxCount, int iterations) {
+	// random boxes with random rotations scattered in a 200 unit cube
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-100.0f, 100.0f), size(0.1f, 2.0f), angle(0.0f, 360.0f);
+	AabbCuller culler;
+	for (size_t i = 0; i < boxCount; ++i) {
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(pos(rng), pos(rng), pos(rng)));
+		m = glm::rotate(m, glm::radians(angle(rng)), glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f)));
+		glm::vec3 half(size(rng), size(rng), size(rng));
+		culler.Add(-half, half, m);
+	}
+
+	glm::mat4 proj = glm::perspective(glm::radians(50.0f), 16.0f / 9.0f, 0.5f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::FromMatrix(proj * view);
+
+	std::vector<unsigned char> result, reference;
+	culler.Cull(frustum, reference, false);
+	for (int mode = 0; mode < 2; ++mode) {
+		bool simd = mode == 0;
+		ResetStats();
+		auto start = std::chrono::steady_clock::now();
+		for (int it = 0; it < iterations; ++it) culler.Cull(frustum, result, simd);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "[AabbCuller] " << (simd ? "SIMD  " : "scalar") << ": " << boxCount << " boxes in "
+			<< ms / iterations << " ms (" << boxCount * iterations / (ms * 1000.0) << " M boxes/s), "
+			<< visible / iterations << " visible" << (result == reference ? "" : " (MISMATCH)") << "\n";
+	}
+	ResetStats();
+}
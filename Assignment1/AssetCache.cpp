@@ -0,0 +1,31 @@
+#include "AssetCache.h"
+
+AssetCache& AssetCache::Instance() {
+	static AssetCache cache;
+	return cache;
+}
+
+std::shared_ptr<ModelAsset> AssetCache::Find(const std::string& key) {
+	auto it = assets.find(key);
+	if (it != assets.end()) {
+		// entry may have expired if every Model using it was destroyed
+		if (std::shared_ptr<ModelAsset> asset = it->second.lock()) {
+			hits++;
+			return asset;
+		}
+		assets.erase(it);
+	}
+	misses++;
+	return nullptr;
+}
+
+void AssetCache::Store(const std::string& key, const std::shared_ptr<ModelAsset>& asset) {
+	assets[key] = asset;
+}
+
+void AssetCache::Prune() {
+	for (auto it = assets.begin(); it != assets.end();) {
+		if (it->second.expired()) it = assets.erase(it);
+		else ++it;
+	}
+}
@@ -1,23 +1,32 @@
 #include"EBO.h"
+#include"GLState.h"
 
 // Constructor that generates a Elements Buffer Object and links it to indices
-EBO::EBO(const std::vector<GLuint>& indices) {
+EBO::EBO(const std::vector<GLuint>& indices)
+	: EBO(indices.data(), indices.size()) {
+}
+
+// Constructor that uploads indices straight from memory
+EBO::EBO(const GLuint* indices, size_t count) {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	// the element binding is VAO state, keep the bound VAO (draws leave it bound) untouched
+	GLState::BindVertexArray(0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), indices, GL_STATIC_DRAW);
 }
 
 // Binds the EBO
 void EBO::Bind() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the EBO
 void EBO::Unbind() {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 // Deletes the EBO
 void EBO::Delete() {
+	GLState::ForgetBuffer(ID);
 	glDeleteBuffers(1, &ID);
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include"FBO.h"
+#include<iostream>
+
+// Constructor that creates the framebuffer and its attachments
+FBO::FBO(int width, int height)
+	: width(width), height(height) {
+	glGenRenderbuffers(1, &colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &ID);
+	glBindFramebuffer(GL_FRAMEBUFFER, ID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	if (!complete) std::cerr << "[FBO] incomplete " << width << "x" << height << " framebuffer" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Binds the FBO and matches the viewport
+void FBO::Bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, ID);
+	glViewport(0, 0, width, height);
+}
+
+// Binds the default framebuffer
+void FBO::Unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Reads the colour attachment back to the CPU
+std::vector<unsigned char> FBO::ReadPixels() {
+	std::vector<unsigned char> pixels((size_t)width * height * 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, ID);
+	// rows are tightly packed, and nothing may sit in the pack buffer slot
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+// Deletes the FBO
+void FBO::Delete() {
+	glDeleteFramebuffers(1, &ID);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+	ID = colorBuffer = depthBuffer = 0;
+}
@@ -0,0 +1,148 @@
+#include "FileUtils.h"
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t h = seed;
+	// mix 8 bytes at a time, the tail byte by byte
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, bytes + i, 8);
+		h = (h ^ word) * FNV_PRIME;
+	}
+	for (; i < size; ++i) {
+		h = (h ^ bytes[i]) * FNV_PRIME;
+	}
+	return h;
+}
+
+uint64_t hashString(const std::string& s, uint64_t seed) {
+	return hashBytes(s.data(), s.size(), seed);
+}
+
+bool hashFile(const std::string& path, uint64_t& hash) {
+	MappedFile file;
+	if (!file.Open(path)) return false;
+	hash = hashBytes(file.data(), file.size());
+	return true;
+}
+
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& out) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	in.seekg(0, std::ios::end);
+	out.resize(static_cast<size_t>(in.tellg()));
+	in.seekg(0, std::ios::beg);
+	in.read(reinterpret_cast<char*>(out.data()), out.size());
+	return static_cast<bool>(in);
+}
+
+bool writeFileAtomic(const std::string& path, const void* data, size_t size) {
+	std::string tmpPath = path + ".tmp";
+	{
+		std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+		if (!out) return false;
+		out.write(static_cast<const char*>(data), size);
+		if (!out) return false;
+	}
+	// rename won't replace an existing file on Windows
+	std::remove(path.c_str());
+	return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool ensureDirectory(const std::string& path) {
+#ifdef _WIN32
+	return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+	return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+std::string cacheFileName(const std::string& sourcePath) {
+	std::string name = sourcePath;
+	for (char& c : name) {
+		if (c == '/' || c == '\\' || c == ':' || c == ' ' || c == '.') c = '_';
+	}
+	return name;
+}
+
+bool MappedFile::Open(const std::string& path) {
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	ptr = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int handle = open(path.c_str(), O_RDONLY);
+	if (handle < 0) return false;
+	struct stat st;
+	if (fstat(handle, &st) != 0 || st.st_size == 0) {
+		close(handle);
+		return false;
+	}
+	void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, handle, 0);
+	if (view == MAP_FAILED) {
+		close(handle);
+		return false;
+	}
+	fd = handle;
+	ptr = static_cast<const unsigned char*>(view);
+	length = static_cast<size_t>(st.st_size);
+#endif
+	return true;
+}
+
+void MappedFile::Close() {
+	if (!ptr) return;
+#ifdef _WIN32
+	UnmapViewOfFile(ptr);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	munmap(const_cast<unsigned char*>(ptr), length);
+	close(fd);
+	fd = -1;
+#endif
+	ptr = nullptr;
+	length = 0;
+}
@@ -0,0 +1,130 @@
+#include "FrameBenchmark.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+double nowMs() {
+	using clock = std::chrono::steady_clock;
+	return std::chrono::duration<double, std::milli>(clock::now().time_since_epoch()).count();
+}
+
+// GL strings can contain anything, keep the JSON valid
+std::string jsonString(const char* s) {
+	std::string out = "\"";
+	for (const char* c = s ? s : ""; *c; ++c) {
+		if (*c == '"' || *c == '\\') out += '\\';
+		if ((unsigned char)*c < 0x20) continue;
+		out += *c;
+	}
+	return out + "\"";
+}
+
+template <typename T>
+void writeSummary(std::ofstream& out, const std::vector<T>& values) {
+	std::vector<double> v(values.begin(), values.end());
+	double sum = 0.0;
+	for (double x : v) sum += x;
+	double avg = v.empty() ? 0.0 : sum / v.size();
+	out << "{ \"min\": " << (v.empty() ? 0.0 : *std::min_element(v.begin(), v.end()))
+		<< ", \"avg\": " << avg
+		<< ", \"p50\": " << FrameBenchmark::Percentile(v, 0.50)
+		<< ", \"p95\": " << FrameBenchmark::Percentile(v, 0.95)
+		<< ", \"p99\": " << FrameBenchmark::Percentile(v, 0.99)
+		<< ", \"max\": " << (v.empty() ? 0.0 : *std::max_element(v.begin(), v.end())) << " }";
+}
+
+} // namespace
+
+BenchmarkOptions BenchmarkOptions::Parse(int argc, char** argv) {
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--benchmark") == 0) options.enabled = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) options.measuredFrames = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) options.warmupFrames = std::max(0, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--crowd") == 0 && hasValue) options.crowd = std::max(0, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--out") == 0 && hasValue) options.output = argv[++i];
+	}
+	return options;
+}
+
+FrameBenchmark::FrameBenchmark(const BenchmarkOptions& options)
+	: options(options) {
+	frameMs.reserve(options.measuredFrames);
+	drawCalls.reserve(options.measuredFrames);
+	stateCalls.reserve(options.measuredFrames);
+}
+
+void FrameBenchmark::AddLoadPhase(const char* name, double ms) {
+	loadPhases.emplace_back(name, ms);
+	std::cout << "[Benchmark] " << name << ": " << ms << " ms" << std::endl;
+}
+
+void FrameBenchmark::BeginFrame() {
+	frameStart = nowMs();
+}
+
+void FrameBenchmark::EndFrame(size_t draws, size_t stateChanges) {
+	glFinish();
+	double ms = nowMs() - frameStart;
+	if (measuring()) {
+		frameMs.push_back(ms);
+		drawCalls.push_back(draws);
+		stateCalls.push_back(stateChanges);
+	}
+	frameIndex++;
+}
+
+double FrameBenchmark::Percentile(std::vector<double> samples, double p) {
+	if (samples.empty()) return 0.0;
+	std::sort(samples.begin(), samples.end());
+	size_t rank = (size_t)std::ceil(p * samples.size());
+	return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+bool FrameBenchmark::WriteReport(int width, int height) const {
+	std::ofstream out(options.output);
+	if (!out) {
+		std::cerr << "[Benchmark] can't write " << options.output << std::endl;
+		return false;
+	}
+	out << "{\n";
+	out << "  \"renderer\": " << jsonString(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << ",\n";
+	out << "  \"version\": " << jsonString(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << ",\n";
+	out << "  \"width\": " << width << ", \"height\": " << height << ",\n";
+	out << "  \"warmupFrames\": " << options.warmupFrames << ", \"measuredFrames\": " << frameMs.size()
+		<< ", \"crowd\": " << options.crowd << ",\n";
+
+	out << "  \"loadMs\": {";
+	for (size_t i = 0; i < loadPhases.size(); i++) {
+		out << (i ? ", " : " ") << jsonString(loadPhases[i].first.c_str()) << ": " << loadPhases[i].second;
+	}
+	out << " },\n";
+
+	out << "  \"frameMs\": ";
+	writeSummary(out, frameMs);
+	out << ",\n  \"drawCalls\": ";
+	writeSummary(out, drawCalls);
+	out << ",\n  \"stateCalls\": ";
+	writeSummary(out, stateCalls);
+
+	out << ",\n  \"frames\": [";
+	for (size_t i = 0; i < frameMs.size(); i++) {
+		out << (i % 8 ? " " : "\n    ") << frameMs[i] << (i + 1 < frameMs.size() ? "," : "");
+	}
+	out << "\n  ]\n}\n";
+
+	double total = 0.0;
+	for (double ms : frameMs) total += ms;
+	std::cout << "[Benchmark] " << frameMs.size() << " frames, avg "
+		<< (frameMs.empty() ? 0.0 : total / frameMs.size()) << " ms, p99 " << Percentile(frameMs, 0.99)
+		<< " ms -> " << options.output << std::endl;
+	return true;
+}
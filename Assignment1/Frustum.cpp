@@ -0,0 +1,40 @@
+#include "Frustum.h"
+
+Frustum Frustum::FromMatrix(const glm::mat4& m) {
+	Frustum f;
+	// rows of the matrix (glm is column-major)
+	glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	f.planes[Left] = row3 + row0;
+	f.planes[Right] = row3 - row0;
+	f.planes[Bottom] = row3 + row1;
+	f.planes[Top] = row3 - row1;
+	f.planes[Near] = row3 + row2;
+	f.planes[Far] = row3 - row2;
+
+	// normalize so plane distances are real distances
+	for (glm::vec4& p : f.planes) {
+		float len = glm::length(glm::vec3(p));
+		if (len > 0.0f) p /= len;
+	}
+	return f;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+	for (const glm::vec4& p : planes) {
+		if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+	}
+	return true;
+}
+
+bool Frustum::IntersectsAABB(const glm::vec3& center, const glm::vec3& extent) const {
+	for (const glm::vec4& p : planes) {
+		// projected radius of the box onto the plane normal
+		float r = glm::dot(glm::abs(glm::vec3(p)), extent);
+		if (glm::dot(glm::vec3(p), center) + p.w < -r) return false;
+	}
+	return true;
+}
@@ -0,0 +1,86 @@
+#include"GLExt.h"
+#include<cstring>
+#include<iostream>
+
+PFNGLBUFFERSTORAGEPROC glext_glBufferStorage = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect = nullptr;
+PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glext_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri = nullptr;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR = nullptr;
+
+namespace GLExt
+{
+	bool hasBufferStorage = false;
+	bool hasS3TC = false;
+	bool hasBPTC = false;
+	bool hasMultiDrawIndirect = false;
+	bool hasProgramBinary = false;
+	bool hasParallelShaderCompile = false;
+
+	bool HasExtension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const char* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (ext && std::strcmp(ext, name) == 0) return true;
+		}
+		return false;
+	}
+
+	void Load(GLADloadproc loader) {
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		bool gl44 = major > 4 || (major == 4 && minor >= 4);
+
+		// persistent mapped buffers
+		if (gl44 || HasExtension("GL_ARB_buffer_storage")) {
+			glext_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)loader("glBufferStorage");
+		}
+		hasBufferStorage = glext_glBufferStorage != nullptr;
+
+		// compressed texture formats
+		bool gl42 = major > 4 || (major == 4 && minor >= 2);
+		hasS3TC = HasExtension("GL_EXT_texture_compression_s3tc");
+		hasBPTC = gl42 || HasExtension("GL_ARB_texture_compression_bptc");
+
+		// batched draws, per-draw data is fetched through baseInstance
+		bool gl43 = major > 4 || (major == 4 && minor >= 3);
+		if (gl43 || (HasExtension("GL_ARB_multi_draw_indirect") && HasExtension("GL_ARB_base_instance"))) {
+			glext_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)loader("glMultiDrawElementsIndirect");
+		}
+		hasMultiDrawIndirect = glext_glMultiDrawElementsIndirect != nullptr;
+
+		// cached program binaries, only useful if the driver offers a format
+		bool gl41 = major > 4 || (major == 4 && minor >= 1);
+		if (gl41 || HasExtension("GL_ARB_get_program_binary")) {
+			glext_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)loader("glGetProgramBinary");
+			glext_glProgramBinary = (PFNGLPROGRAMBINARYPROC)loader("glProgramBinary");
+			glext_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)loader("glProgramParameteri");
+		}
+		GLint binaryFormats = 0;
+		if (glext_glGetProgramBinary && glext_glProgramBinary && glext_glProgramParameteri)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+		hasProgramBinary = binaryFormats > 0;
+
+		// compile in driver threads and poll for completion
+		if (HasExtension("GL_KHR_parallel_shader_compile")) {
+			glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)loader("glMaxShaderCompilerThreadsKHR");
+			hasParallelShaderCompile = true;
+		}
+		else if (HasExtension("GL_ARB_parallel_shader_compile")) {
+			glext_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)loader("glMaxShaderCompilerThreadsARB");
+			hasParallelShaderCompile = true;
+		}
+		// let the driver pick as many threads as it likes
+		if (glext_glMaxShaderCompilerThreadsKHR) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+
+		std::cout << "[GL] " << glGetString(GL_VERSION) << " | buffer storage: "
+			<< (hasBufferStorage ? "yes" : "no") << " | S3TC: " << (hasS3TC ? "yes" : "no")
+			<< " | BPTC: " << (hasBPTC ? "yes" : "no")
+			<< " | multi-draw indirect: " << (hasMultiDrawIndirect ? "yes" : "no")
+			<< " | program binary: " << (hasProgramBinary ? "yes" : "no")
+			<< " | parallel shader compile: " << (hasParallelShaderCompile ? "yes" : "no") << std::endl;
+	}
+}
@@ -0,0 +1,132 @@
+#include "GLState.h"
+
+namespace {
+
+// nothing known, the next bind always goes to the driver
+const GLuint UNKNOWN = ~0u;
+
+enum BufferSlot { ArrayBuffer, ElementBuffer, UniformBuffer, PixelUnpackBuffer, BUFFER_SLOTS };
+
+GLuint program = UNKNOWN;
+GLuint vertexArray = UNKNOWN;
+GLuint buffers[BUFFER_SLOTS] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+GLuint activeUnit = UNKNOWN;
+// texture bound to each unit
+struct TextureUnits {
+	GLuint ids[GLState::MAX_TEXTURE_UNITS];
+	TextureUnits() { Clear(); }
+	void Clear() { for (GLuint& t : ids) t = UNKNOWN; }
+} textures;
+
+int bufferSlot(GLenum target) {
+	switch (target) {
+	case GL_ARRAY_BUFFER: return ArrayBuffer;
+	case GL_ELEMENT_ARRAY_BUFFER: return ElementBuffer;
+	case GL_UNIFORM_BUFFER: return UniformBuffer;
+	case GL_PIXEL_UNPACK_BUFFER: return PixelUnpackBuffer;
+	default: return -1;
+	}
+}
+
+// true if the cached value already matches, otherwise records the new one
+bool unchanged(GLuint& cached, GLuint value) {
+	if (cached == value) {
+		GLState::elided++;
+		return true;
+	}
+	cached = value;
+	GLState::issued++;
+	return false;
+}
+
+} // namespace
+
+size_t GLState::issued = 0;
+size_t GLState::elided = 0;
+
+void GLState::UseProgram(GLuint id) {
+	if (unchanged(program, id)) return;
+	glUseProgram(id);
+}
+
+void GLState::BindVertexArray(GLuint vao) {
+	if (unchanged(vertexArray, vao)) return;
+	glBindVertexArray(vao);
+	// the element buffer binding belongs to the VAO
+	buffers[ElementBuffer] = UNKNOWN;
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+	int slot = bufferSlot(target);
+	if (slot < 0) {
+		issued++;
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (unchanged(buffers[slot], buffer)) return;
+	glBindBuffer(target, buffer);
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) {
+	issued++;
+	glBindBufferRange(target, index, buffer, (GLintptr)offset, (GLsizeiptr)size);
+	int slot = bufferSlot(target);
+	if (slot >= 0) buffers[slot] = buffer;
+}
+
+void GLState::ActiveTexture(GLuint unit) {
+	if (unchanged(activeUnit, unit)) return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::BindTexture(GLuint unit, GLuint texture) {
+	if (unit >= MAX_TEXTURE_UNITS) {
+		ActiveTexture(unit);
+		issued++;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		return;
+	}
+	if (textures.ids[unit] == texture) {
+		elided++;
+		return;
+	}
+	ActiveTexture(unit);
+	unchanged(textures.ids[unit], texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GLState::ForgetProgram(GLuint id) {
+	if (program == id) program = UNKNOWN;
+}
+
+void GLState::ForgetVertexArray(GLuint vao) {
+	if (vertexArray == vao) {
+		vertexArray = UNKNOWN;
+		buffers[ElementBuffer] = UNKNOWN;
+	}
+}
+
+void GLState::ForgetBuffer(GLuint buffer) {
+	for (GLuint& b : buffers) {
+		if (b == buffer) b = UNKNOWN;
+	}
+}
+
+void GLState::ForgetTexture(GLuint texture) {
+	for (GLuint& t : textures.ids) {
+		if (t == texture) t = UNKNOWN;
+	}
+}
+
+void GLState::Invalidate() {
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	for (GLuint& b : buffers) b = UNKNOWN;
+	activeUnit = UNKNOWN;
+	textures.Clear();
+}
+
+void GLState::ResetStats() {
+	issued = 0;
+	elided = 0;
+}
@@ -0,0 +1,156 @@
+#include "GeometryPool.h"
+#include "GLState.h"
+#include "Mesh.h"
+#include "RingBuffer.h"
+#include <cstring>
+
+namespace {
+
+// one pool per vertex layout
+std::vector<std::unique_ptr<GeometryPool>> pools;
+
+size_t vertexSize(VertexFormat format) {
+	return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+// copies size bytes between buffers on the GPU
+void copyBuffer(GLuint src, size_t srcOffset, GLuint dst, size_t dstOffset, size_t size) {
+	if (size == 0) return;
+	GLState::BindBuffer(GL_COPY_READ_BUFFER, src);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, dst);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffset, dstOffset, size);
+}
+
+} // namespace
+
+GeometryPool* GeometryPool::Acquire(Mesh& mesh) {
+	if (mesh.pool) return mesh.pool;
+	if (mesh.drawMode != GL_TRIANGLES) return nullptr;
+	// float vertices carry their own color
+	bool hasColor = mesh.format == VertexFormat::Float || mesh.hasColor;
+
+	GeometryPool* pool = nullptr;
+	for (auto& p : pools) {
+		if (p->format == mesh.format && p->hasColor == hasColor) pool = p.get();
+	}
+	if (!pool) {
+		pools.emplace_back(new GeometryPool(mesh.format, hasColor));
+		pool = pools.back().get();
+	}
+	pool->add(mesh);
+	return pool;
+}
+
+void GeometryPool::DeleteAll() {
+	pools.clear();
+}
+
+GeometryPool::GeometryPool(VertexFormat format, bool hasColor)
+	: format(format), hasColor(hasColor) {
+}
+
+void GeometryPool::add(Mesh& mesh) {
+	reserve(vertexCount + mesh.vertexCount, indexCount + mesh.indexCount);
+
+	size_t stride = vertexSize(format);
+	copyBuffer(mesh.vertexBuffer().ID, 0, vertices->ID, vertexCount * stride, mesh.vertexCount * stride);
+	// packed colors follow the vertices in the mesh's buffer
+	if (colors) {
+		copyBuffer(mesh.vertexBuffer().ID, mesh.vertexCount * stride, colors->ID,
+			vertexCount * sizeof(uint32_t), mesh.vertexCount * sizeof(uint32_t));
+	}
+	copyBuffer(mesh.indexBuffer().ID, 0, indices->ID, indexCount * sizeof(GLuint), mesh.indexCount * sizeof(GLuint));
+
+	// the mesh's indices stay local, commands add the base vertex
+	mesh.pool = this;
+	mesh.poolBaseVertex = static_cast<GLint>(vertexCount);
+	mesh.poolFirstIndex = static_cast<GLuint>(indexCount);
+	vertexCount += mesh.vertexCount;
+	indexCount += mesh.indexCount;
+}
+
+void GeometryPool::reserve(size_t vertexNeeded, size_t indexNeeded) {
+	if (vertices && vertexNeeded <= vertexCapacity && indexNeeded <= indexCapacity) return;
+
+	// grow geometrically, starting big enough for a few models
+	size_t newVertexCapacity = vertexCapacity > 0 ? vertexCapacity : 65536;
+	while (newVertexCapacity < vertexNeeded) newVertexCapacity *= 2;
+	size_t newIndexCapacity = indexCapacity > 0 ? indexCapacity : 262144;
+	while (newIndexCapacity < indexNeeded) newIndexCapacity *= 2;
+
+	size_t stride = vertexSize(format);
+	std::unique_ptr<VBO> newVertices(new VBO(static_cast<const void*>(nullptr), newVertexCapacity * stride));
+	std::unique_ptr<VBO> newColors;
+	if (format == VertexFormat::Packed && hasColor)
+		newColors.reset(new VBO(static_cast<const void*>(nullptr), newVertexCapacity * sizeof(uint32_t)));
+	std::unique_ptr<EBO> newIndices(new EBO(static_cast<const GLuint*>(nullptr), newIndexCapacity));
+
+	// keep what is already pooled
+	if (vertices) {
+		copyBuffer(vertices->ID, 0, newVertices->ID, 0, vertexCount * stride);
+		if (colors) copyBuffer(colors->ID, 0, newColors->ID, 0, vertexCount * sizeof(uint32_t));
+		copyBuffer(indices->ID, 0, newIndices->ID, 0, indexCount * sizeof(GLuint));
+	}
+	vertices = std::move(newVertices);
+	colors = std::move(newColors);
+	indices = std::move(newIndices);
+	vertexCapacity = newVertexCapacity;
+	indexCapacity = newIndexCapacity;
+	link();
+}
+
+void GeometryPool::link() {
+	vao.Bind();
+	indices->Bind();
+	Mesh::LinkAttributes(vao, *vertices, format, colors.get(), 0);
+
+	// per-draw data lives in the frame ring, advanced once per instance so
+	// baseInstance picks the draw (the ring buffer object never changes)
+	VBO& drawBuffer = RingBuffer::Shared().buffer();
+	GLsizei stride = sizeof(DrawData);
+	for (GLuint column = 0; column < 4; column++) {
+		vao.LinkVBO(drawBuffer, 4 + column, 4, stride,
+			(void*)(offsetof(DrawData, model) + column * sizeof(glm::vec4)));
+		vao.SetDivisor(4 + column, 1);
+	}
+	for (GLuint column = 0; column < 3; column++) {
+		vao.LinkVBO(drawBuffer, 11 + column, 3, stride,
+			(void*)(offsetof(DrawData, normalMatrix) + column * sizeof(glm::vec4)));
+		vao.SetDivisor(11 + column, 1);
+	}
+	vao.LinkVBOI(drawBuffer, 8, 1, GL_INT, stride, (void*)offsetof(DrawData, materialIndex));
+	vao.SetDivisor(8, 1);
+	vao.LinkVBO(drawBuffer, 9, 3, stride, (void*)offsetof(DrawData, posScale));
+	vao.SetDivisor(9, 1);
+	vao.LinkVBO(drawBuffer, 10, 3, stride, (void*)offsetof(DrawData, posOffset));
+	vao.SetDivisor(10, 1);
+	vao.Unbind();
+}
+
+void GeometryPool::MultiDraw(GLenum mode, const std::vector<DrawElementsIndirectCommand>& commands,
+	const std::vector<DrawData>& draws) {
+	if (commands.empty()) return;
+	RingBuffer& ring = RingBuffer::Shared();
+
+	// draw data aligned to its own size, so its offset is a whole number of instances
+	size_t drawOffset = 0, commandOffset = 0;
+	DrawData* dst = static_cast<DrawData*>(ring.Allocate(draws.size() * sizeof(DrawData), sizeof(DrawData), drawOffset));
+	if (!dst) return;
+	std::memcpy(dst, draws.data(), draws.size() * sizeof(DrawData));
+	GLuint firstDraw = static_cast<GLuint>(drawOffset / sizeof(DrawData));
+
+	size_t commandBytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+	DrawElementsIndirectCommand* cmd = static_cast<DrawElementsIndirectCommand*>(
+		ring.Allocate(commandBytes, sizeof(GLuint), commandOffset));
+	if (!cmd) return;
+	for (size_t i = 0; i < commands.size(); ++i) {
+		cmd[i] = commands[i];
+		cmd[i].baseInstance += firstDraw;
+	}
+	ring.Flush();
+
+	vao.Bind();
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.buffer().ID);
+	glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset),
+		(GLsizei)commands.size(), 0);
+}
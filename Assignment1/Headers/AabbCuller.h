@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+// Frustum culling of axis-aligned boxes in batches. Boxes are added in
+// world space each frame (Add transforms them), stored as center/extent
+// structure-of-arrays and tested four at a time with SSE2.
+class AabbCuller
+{
+public:
+	// global switch (ImGui)
+	static bool enabled;
+	// boxes tested / found visible since the last ResetStats
+	static size_t tested;
+	static size_t visible;
+	static void ResetStats();
+
+	// World space box of a local AABB under a transform
+	static void Transform(const glm::mat4& m, const glm::vec3& aabbMin, const glm::vec3& aabbMax,
+		glm::vec3& center, glm::vec3& extent);
+
+	// Removes all boxes (keeps the memory)
+	void Clear();
+	// Adds a local AABB placed by m, returns its index
+	size_t Add(const glm::vec3& aabbMin, const glm::vec3& aabbMax, const glm::mat4& m);
+	size_t size() const { return count; }
+
+	// visibleOut[i] is 1 if box i is at least partly inside the frustum
+	void Cull(const Frustum& frustum, std::vector<unsigned char>& visibleOut, bool simd = true);
+
+	// Culls boxCount random boxes on the CPU only, prints SIMD vs scalar timings
+	static void Benchmark(size_t boxCount, int iterations);
+
+private:
+	size_t count = 0;
+	// padded to a multiple of 4 in Cull with boxes that are always culled
+	std::vector<float> cx, cy, cz, ex, ey, ez;
+
+	// visibility of boxes [begin, begin + 4) as a 4-bit mask
+	unsigned int testSimd(size_t begin, const Frustum& frustum) const;
+	bool testScalar(size_t i, const Frustum& frustum) const;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "Mesh.h"
+
+// Immutable data of one imported model file, shared by every Model instance
+struct ModelAsset
+{
+	std::vector<std::shared_ptr<Mesh>> meshes;
+	// model space bounds
+	glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
+};
+
+class AssetCache
+{
+public:
+	// Global cache used by Model
+	static AssetCache& Instance();
+
+	// Returns the asset stored under key, or nullptr if it is not loaded
+	std::shared_ptr<ModelAsset> Find(const std::string& key);
+	// Registers a freshly loaded asset
+	void Store(const std::string& key, const std::shared_ptr<ModelAsset>& asset);
+	// Removes entries whose asset has already been released
+	void Prune();
+
+	// Simple stats
+	unsigned int hits = 0;
+	unsigned int misses = 0;
+	size_t size() const { return assets.size(); }
+
+private:
+	// weak so GPU data is freed once the last Model using it is gone
+	std::unordered_map<std::string, std::weak_ptr<ModelAsset>> assets;
+};
@@ -2,6 +2,7 @@
 
 #include<glad/glad.h>
 #include<vector>
+#include<cstddef>
 
 class EBO
 {
@@ -10,6 +11,8 @@ public:
 	GLuint ID;
 	// Constructor that generates a Elements Buffer Object and links it to indices
 	EBO(const std::vector<GLuint>& indices);
+	// Same, but from raw memory (e.g. a mapped cache file)
+	EBO(const GLuint* indices, size_t count);
 	// Destructor
 	~EBO() {
 		if (ID != 0) Delete();
@@ -0,0 +1,41 @@
+#pragma once
+
+#include<glad/glad.h>
+#include<vector>
+
+// Offscreen render target: RGBA8 colour and 24-bit depth renderbuffers
+class FBO
+{
+public:
+	// Reference ID of the Framebuffer Object
+	GLuint ID = 0;
+	GLuint colorBuffer = 0;
+	GLuint depthBuffer = 0;
+	int width;
+	int height;
+
+	// Constructor that creates the framebuffer and its attachments
+	FBO(int width, int height);
+	// Destructor
+	~FBO() {
+		if (ID != 0) Delete();
+	}
+
+	// Prevent copying
+	FBO(const FBO&) = delete;
+	FBO& operator=(const FBO&) = delete;
+
+	// True if the framebuffer can be rendered to
+	bool Complete() const { return complete; }
+	// Binds the FBO for drawing and reading, and sets the viewport to its size
+	void Bind();
+	// Binds the default framebuffer again
+	void Unbind();
+	// Reads the colour buffer back as RGBA8, bottom row first (waits for the GPU)
+	std::vector<unsigned char> ReadPixels();
+	// Deletes the FBO
+	void Delete();
+
+private:
+	bool complete = false;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// 64-bit FNV-1a style hash used to key/invalidate the on-disk caches
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+uint64_t hashString(const std::string& s, uint64_t seed = 14695981039346656037ull);
+// Hashes the whole content of a file, returns false if it can't be read
+bool hashFile(const std::string& path, uint64_t& hash);
+
+// Whole-file helpers
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& out);
+// Writes to a temp file first and renames it, so readers never see half a file
+bool writeFileAtomic(const std::string& path, const void* data, size_t size);
+// Creates a single directory level if it doesn't exist yet
+bool ensureDirectory(const std::string& path);
+// Turns a source path into something usable as a cache file name
+std::string cacheFileName(const std::string& sourcePath);
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { Close(); }
+
+	// Prevent copying (owns OS handles)
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the file, returns false if it doesn't exist or is empty
+	bool Open(const std::string& path);
+	// Unmaps the file
+	void Close();
+
+	const unsigned char* data() const { return ptr; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char* ptr = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fd = -1;
+#endif
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Settings of a headless benchmark run, from the command line:
+//     --benchmark [--frames N] [--warmup N] [--crowd N] [--out report.json]
+struct BenchmarkOptions
+{
+	bool enabled = false;
+	int warmupFrames = 60;
+	int measuredFrames = 300;
+	// instanced teapots behind the three, 0 leaves the crowd off
+	int crowd = 0;
+	std::string output = "benchmark.json";
+
+	static BenchmarkOptions Parse(int argc, char** argv);
+};
+
+// Times the frames of a headless run and writes the JSON report. Every frame
+// ends with glFinish, so a frame's time covers its GPU work and does not
+// depend on how far the driver lets the CPU run ahead.
+class FrameBenchmark
+{
+public:
+	explicit FrameBenchmark(const BenchmarkOptions& options);
+
+	// Records a load phase (context, shaders, models, ...) in milliseconds
+	void AddLoadPhase(const char* name, double ms);
+
+	// Frame index since the start, warm-up frames included
+	int frame() const { return frameIndex; }
+	bool measuring() const { return frameIndex >= options.warmupFrames; }
+	bool done() const { return frameIndex >= options.warmupFrames + options.measuredFrames; }
+
+	void BeginFrame();
+	// Waits for the GPU and stores the frame if it is past the warm-up
+	void EndFrame(size_t drawCalls, size_t stateCalls);
+
+	// Writes the report to options.output, false if the file can't be written
+	bool WriteReport(int width, int height) const;
+
+	// percentile of a sample set (nearest rank), 0 if empty
+	static double Percentile(std::vector<double> samples, double p);
+
+private:
+	BenchmarkOptions options;
+	int frameIndex = 0;
+	double frameStart = 0.0;
+	std::vector<std::pair<std::string, double>> loadPhases;
+	std::vector<double> frameMs;
+	std::vector<size_t> drawCalls;
+	std::vector<size_t> stateCalls;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (n.p + d >= 0 is inside)
+class Frustum
+{
+public:
+	enum { Left, Right, Bottom, Top, Near, Far, COUNT };
+	glm::vec4 planes[COUNT];
+
+	// Extracts the planes of a projection * view (* model) matrix (Gribb/Hartmann).
+	// With a model matrix included the planes come out in model space.
+	static Frustum FromMatrix(const glm::mat4& m);
+
+	// True if the sphere is at least partly inside
+	bool IntersectsSphere(const glm::vec3& center, float radius) const;
+	// True if the box (center, half size) is at least partly inside (conservative near corners)
+	bool IntersectsAABB(const glm::vec3& center, const glm::vec3& extent) const;
+};
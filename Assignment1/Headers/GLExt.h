@@ -0,0 +1,101 @@
+#pragma once
+
+// OpenGL entry points and enums newer than the GL 3.3 glad loader.
+// They are loaded at runtime and only used when the driver supports them,
+// every caller keeps a GL 3.3 fallback.
+
+#include<glad/glad.h>
+
+// -------------------- Enums --------------------
+
+// GL_ARB_buffer_storage (core 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+// GL_EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+
+// GL_ARB_texture_compression_bptc (core 4.2)
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// GL_ARB_draw_indirect (core 4.0)
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// GL_ARB_get_program_binary (core 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// GL_KHR_parallel_shader_compile (same values as the ARB version)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// -------------------- Entry points --------------------
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glext_glBufferStorage;
+#define glBufferStorage glext_glBufferStorage
+
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glext_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glext_glMultiDrawElementsIndirect
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+extern PFNGLGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+#define glGetProgramBinary glext_glGetProgramBinary
+
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+extern PFNGLPROGRAMBINARYPROC glext_glProgramBinary;
+#define glProgramBinary glext_glProgramBinary
+
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+#define glProgramParameteri glext_glProgramParameteri
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glext_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glext_glMaxShaderCompilerThreadsKHR
+
+// Layout of one command in a GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+namespace GLExt
+{
+	// Feature flags, valid after Load()
+	extern bool hasBufferStorage;
+	extern bool hasS3TC;
+	extern bool hasBPTC;
+	// glMultiDrawElementsIndirect with a working baseInstance (4.3 or ARB_multi_draw_indirect + ARB_base_instance)
+	extern bool hasMultiDrawIndirect;
+	// glGetProgramBinary / glProgramBinary with at least one binary format
+	extern bool hasProgramBinary;
+	// GL_COMPLETION_STATUS_KHR can be polled without waiting for the compiler
+	extern bool hasParallelShaderCompile;
+
+	// Loads the extra entry points, call once after gladLoadGL
+	void Load(GLADloadproc loader);
+	// True if the current context advertises the extension
+	bool HasExtension(const char* name);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Shadow copy of the GL bindings the wrappers change (program, VAO,
+// buffers, textures). Every bind goes through here and is skipped when the
+// object is already bound. Render thread only.
+
+#include<glad/glad.h>
+#include<cstddef>
+
+class GLState
+{
+public:
+	// texture units tracked by the cache, higher units are passed through
+	static const GLuint MAX_TEXTURE_UNITS = 32;
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vao);
+	// ARRAY, ELEMENT_ARRAY, UNIFORM and PIXEL_UNPACK buffers are cached
+	static void BindBuffer(GLenum target, GLuint buffer);
+	// Indexed range binding, also changes the generic binding of target
+	static void BindBufferRange(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size);
+	static void ActiveTexture(GLuint unit);
+	// Binds a GL_TEXTURE_2D to a unit (switching the active unit if needed)
+	static void BindTexture(GLuint unit, GLuint texture);
+
+	// Must be called when an object is deleted, its ID can be reused
+	static void ForgetProgram(GLuint program);
+	static void ForgetVertexArray(GLuint vao);
+	static void ForgetBuffer(GLuint buffer);
+	static void ForgetTexture(GLuint texture);
+	// Forgets everything, for when code outside the wrappers changed state
+	static void Invalidate();
+
+	// Calls sent to the driver / skipped as redundant since ResetStats
+	static size_t issued;
+	static size_t elided;
+	static void ResetStats();
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "VAO.h"
+#include "VBO.h"
+#include "EBO.h"
+#include "GLExt.h"
+#include "MeshData.h"
+class Mesh;
+
+// Per-draw data of a batched draw, read by scene.vert as instance attributes
+// (locations 4-13) selected by the command's baseInstance
+struct DrawData
+{
+	glm::mat4 model;
+	glm::vec4 normalMatrix[3]; // xyz columns
+	glm::vec4 posScale;  // xyz, packed vertex dequantization
+	glm::vec4 posOffset; // xyz
+	GLint materialIndex;
+	GLint padding[3]; // keeps the stride a multiple of 16 bytes
+};
+
+// Shared vertex/index buffers for all meshes with one vertex layout, so they
+// can be drawn together with glMultiDrawElementsIndirect. Meshes are copied
+// in on the GPU the first time they are batched and keep their place for
+// good (the pool only grows).
+class GeometryPool
+{
+public:
+	// The pool for the mesh's layout with the mesh copied in, or nullptr if
+	// the mesh can't be batched (not triangles)
+	static GeometryPool* Acquire(Mesh& mesh);
+	// Deletes every pool, call while the context is alive (after the last draw)
+	static void DeleteAll();
+
+	GeometryPool(VertexFormat format, bool hasColor);
+
+	// Prevent copying
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	// Streams the per-draw data and commands through the frame ring and issues one multi-draw
+	void MultiDraw(GLenum mode, const std::vector<DrawElementsIndirectCommand>& commands,
+		const std::vector<DrawData>& draws);
+
+	const VertexFormat format;
+	const bool hasColor;
+
+private:
+	VAO vao;
+	std::unique_ptr<VBO> vertices;
+	std::unique_ptr<VBO> colors;
+	std::unique_ptr<EBO> indices;
+	size_t vertexCapacity = 0, vertexCount = 0;
+	size_t indexCapacity = 0, indexCount = 0;
+
+
+	void add(Mesh& mesh);
+	// makes room for more vertices/indices, keeping the contents
+	void reserve(size_t vertexNeeded, size_t indexNeeded);
+	// links the pool buffers and the ring (draw data) into the vao
+	void link();
+};
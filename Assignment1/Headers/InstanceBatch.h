@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "VAO.h"
+#include "VBO.h"
+class Model;
+class Mesh;
+class Shader;
+
+// Per-instance data read by scene.vert (locations 4-7, 8 and 11-13)
+struct InstanceData
+{
+	glm::mat4 model;
+	glm::vec4 normalMatrix[3]; // xyz columns, vec4 keeps them 16-byte aligned
+	GLint materialIndex;
+	GLint padding[3]; // keeps the stride a multiple of 16 bytes
+};
+
+// Draws many placements of one model with a single glDrawElementsInstanced
+// per mesh. Instances are collected on the CPU, uploaded to one instance
+// buffer when they change, and every mesh gets its own VAO that combines
+// the mesh's vertex buffers with the per-instance attributes.
+class InstanceBatch
+{
+public:
+	// The model may still be loading; drawing starts once it is ready
+	explicit InstanceBatch(Model& model);
+	~InstanceBatch();
+
+	// Prevent copying
+	InstanceBatch(const InstanceBatch&) = delete;
+	InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+	// Removes all instances
+	void Clear();
+	// Adds one placement (matrix includes the model's own TRS)
+	void Add(const glm::mat4& model, int materialIndex = 0);
+	size_t size() const { return instances.size(); }
+
+	// Uploads if needed and draws every instance at the given LOD
+	void Draw(Shader& shader, size_t lod = 0);
+	// GL draw calls issued by the last Draw
+	size_t drawCalls = 0;
+	// Deletes the GL objects
+	void Delete();
+
+private:
+	Model& model;
+	std::vector<InstanceData> instances;
+	bool dirty = true;
+
+	// created on first draw after the model finished loading
+	std::unique_ptr<VBO> instanceVbo;
+	size_t capacity = 0;
+	std::vector<std::unique_ptr<VAO>> vaos;
+
+	void setup();
+	void upload();
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "TextureCompressor.h"
+
+// On-disk cache of block-compressed textures in the KTX 1.1 container.
+// Files are named after the hash of the source image bytes and the target
+// format, and store that hash again as a key/value entry, so an edited
+// source image simply misses the cache.
+class KtxCache
+{
+public:
+	// directory the .ktx files are written to (relative to the working dir)
+	static const char* DIRECTORY;
+
+	// Reads a cached image, false if missing, stale or unreadable
+	static bool Load(uint64_t sourceHash, BCFormat format, CompressedImage& out);
+	// Writes a compressed image for this source
+	static bool Save(uint64_t sourceHash, const CompressedImage& image);
+
+	// KTX 1.1 (de)serialization without any GL calls
+	static bool Read(const unsigned char* data, size_t size, uint64_t sourceHash, CompressedImage& out);
+	static std::vector<unsigned char> Write(uint64_t sourceHash, const CompressedImage& image);
+
+private:
+	static std::string cachePath(uint64_t sourceHash, BCFormat format);
+};
@@ -8,7 +8,10 @@
 #include "VAO.h"
 #include "EBO.h"
 #include "Texture.h"
+#include "MeshData.h"
+#include "Meshlets.h"
 class Shader;
+class GeometryPool;
 
 class Mesh
 {
@@ -19,11 +22,35 @@ public:
 	// Store model matrix for simple transformations
 	glm::mat4 modelMatrix = glm::mat4(1.0f);
 	GLenum drawMode = GL_TRIANGLES; // default, but can be changed per mesh
+	// number of indices in the EBO (the CPU copies above may be empty)
+	GLsizei indexCount = 0;
+	size_t vertexCount = 0;
+	// index ranges of each level of detail in the EBO, LOD0 first
+	std::vector<MeshLod> lods;
+	// LOD0 clusters for CPU culling (empty if the mesh has no meshlets)
+	ClusterCuller clusters;
+	// mesh space bounds
+	glm::vec3 aabbMin = glm::vec3(0.0f);
+	glm::vec3 aabbMax = glm::vec3(0.0f);
+	// vertex layout in the VBO, the shader is told how to decode it
+	VertexFormat format = VertexFormat::Float;
+	bool hasColor = true;
+	// packed positions: position = q * posScale + posOffset
+	glm::vec3 posScale = glm::vec3(1.0f);
+	glm::vec3 posOffset = glm::vec3(0.0f);
+	// shared buffers the mesh was copied into for batched draws (nullptr if none),
+	// its vertices and indices start at poolBaseVertex / poolFirstIndex there
+	GeometryPool* pool = nullptr;
+	GLint poolBaseVertex = 0;
+	GLuint poolFirstIndex = 0;
 
 	// Initializes the mesh
 	Mesh(const std::vector <Vertex>& vertices,
 		 const std::vector <GLuint>& indices,
 		 const std::vector<std::shared_ptr<Texture>>& textures);
+	// Initializes the mesh from final data without keeping CPU copies
+	Mesh(const MeshView& view,
+		 const std::vector<std::shared_ptr<Texture>>& textures);
 
 	~Mesh() {
 		vao.Delete();
@@ -39,10 +66,42 @@ public:
 	void setRotation(float angle, const glm::vec3& axis);
 	void setScale(const glm::vec3& scale);
 
-	// Draws the mesh
-	void Draw(Shader& shader);
+	// Coarsest LOD whose error stays under maxPixelError at pixelsPerUnit (mesh units)
+	size_t SelectLod(float pixelsPerUnit, float maxPixelError) const;
+
+	// Draws the mesh (at the given level of detail)
+	void Draw(Shader& shader, size_t lod = 0);
+	// Draws instanceCount copies through a vao made with LinkVertexLayout
+	void DrawInstanced(Shader& shader, VAO& instanceVao, GLsizei instanceCount, size_t lod = 0);
+	// Links this mesh's vertex and index buffers into another vao (left bound),
+	// e.g. to add per-instance attributes next to them
+	void LinkVertexLayout(VAO& target);
+	// Links attributes 0-3 of a vertex layout to the bound vao; packed colors are read
+	// from colors at colorOffset, without colors the shader gets white
+	static void LinkAttributes(VAO& target, VBO& vertices, VertexFormat format, VBO* colors, size_t colorOffset);
+	// Binds textures and sets the vertex decode uniforms (no vao)
+	void BindMaterial(Shader& shader);
+	// Draws only the LOD0 clusters that survive culling (frustum/camera in mesh space)
+	void DrawClusters(Shader& shader, const Frustum& frustum, const glm::vec3& cameraPos);
+	// the mesh's own vao, identifies the mesh in sort keys
+	GLuint vertexArray() const { return vao.ID; }
+
+	// the mesh's own buffers (e.g. to copy them into a GeometryPool)
+	VBO& vertexBuffer() { return vbo; }
+	EBO& indexBuffer() { return ebo; }
 
 private:
+	// BindMaterial, then binds the vao
+	void bindForDraw(Shader& shader);
+	// links the vertex layout to the vao
+	void setupVAO();
+	// total VBO size for a view (vertices + optional color stream)
+	static size_t bufferSize(const MeshView& view);
+
+	// visible ranges of the last DrawClusters (kept to avoid reallocating)
+	std::vector<GLsizei> drawCounts;
+	std::vector<const void*> drawOffsets;
+
 	// to be used by Draw
 	VAO vao;
     VBO vbo;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include "FileUtils.h"
+#include "MeshData.h"
+
+// Versioned binary cache of imported models, loaded through a memory mapping.
+// A baked file holds the final interleaved vertices, indices, bounds and
+// texture bindings so a warm start never touches Assimp.
+class MeshCache
+{
+public:
+	// bump whenever the file layout, the Vertex struct or the meaning of baked
+	// data (e.g. LOD errors) changes
+	static const uint32_t VERSION = 5;
+	// directory baked files are written to (relative to the working dir)
+	static const char* DIRECTORY;
+
+	// Maps the baked file for this source if it is still valid
+	bool Load(const std::string& sourcePath, uint32_t importFlags, uint64_t optionsHash);
+	// Writes a baked file for freshly imported data
+	static bool Save(const std::string& sourcePath, uint32_t importFlags, uint64_t optionsHash,
+		const ModelData& data);
+
+	// Views into the mapped file (valid until this object is destroyed)
+	const ModelView& view() const { return modelView; }
+
+private:
+	MappedFile file;
+	ModelView modelView;
+
+	static std::string bakedPath(const std::string& sourcePath, uint64_t optionsHash);
+};
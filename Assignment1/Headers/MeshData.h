@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "VBO.h"
+
+// Vertex layout of a mesh's vertex buffer
+enum class VertexFormat : uint32_t { Float = 0, Packed = 1 };
+
+// Where a mesh gets one of its textures from
+struct TextureRef
+{
+	enum class Source : uint32_t { None = 0, File = 1, Embedded = 2 };
+	Source source = Source::None;
+	std::string path;        // Source::File
+	int embeddedIndex = -1;  // Source::Embedded, index into the model's embedded textures
+};
+
+// One level of detail: a range of the mesh's index buffer
+struct MeshLod
+{
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f; // geometric error in mesh units (0 for the full mesh)
+};
+
+// Small cluster of LOD0 triangles with bounds for CPU culling
+struct Meshlet
+{
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float center[3] = { 0.0f, 0.0f, 0.0f }; // bounding sphere (mesh units)
+	float radius = 0.0f;
+	float coneAxis[3] = { 0.0f, 0.0f, 1.0f }; // average facing direction
+	float coneCutoff = 2.0f; // sin of the normal cone half-angle, > 1 never culls
+};
+
+// Non-owning view of a block of bytes (e.g. a compressed embedded image)
+struct ByteView
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+};
+
+// Non-owning view of one mesh's final data, either from the importer or a baked file
+struct MeshView
+{
+	VertexFormat format = VertexFormat::Float;
+	const Vertex* vertices = nullptr;              // VertexFormat::Float
+	const PackedVertex* packedVertices = nullptr;  // VertexFormat::Packed
+	const uint32_t* colors = nullptr;              // Packed only, RGBA8 or nullptr
+	size_t vertexCount = 0;
+	const GLuint* indices = nullptr;
+	size_t indexCount = 0;
+	// LOD0 first; empty means a single LOD covering all indices
+	const MeshLod* lods = nullptr;
+	size_t lodCount = 0;
+	// clusters covering LOD0 (may be empty)
+	const Meshlet* meshlets = nullptr;
+	size_t meshletCount = 0;
+	glm::vec3 aabbMin = glm::vec3(0.0f);
+	glm::vec3 aabbMax = glm::vec3(0.0f);
+	TextureRef diffuse;
+	TextureRef specular;
+};
+
+// Everything needed to create a ModelAsset on the GPU
+struct ModelView
+{
+	std::vector<MeshView> meshes;
+	std::vector<ByteView> embeddedTextures;
+	glm::vec3 aabbMin = glm::vec3(0.0f);
+	glm::vec3 aabbMax = glm::vec3(0.0f);
+};
+
+// CPU-side mesh produced by the importer, before any GL upload
+struct MeshData
+{
+	VertexFormat format = VertexFormat::Float;
+	std::vector<Vertex> vertices;
+	// filled by VertexPacker::Pack, which empties vertices
+	std::vector<PackedVertex> packedVertices;
+	std::vector<uint32_t> colors;
+	// the source had vertex colors (otherwise they are all white)
+	bool hasColor = false;
+	std::vector<GLuint> indices;
+	// index ranges of each LOD (filled by MeshSimplifier::BuildLods)
+	std::vector<MeshLod> lods;
+	// clusters of LOD0 (filled by MeshletBuilder::Build)
+	std::vector<Meshlet> meshlets;
+	glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
+	TextureRef diffuse;
+	TextureRef specular;
+};
+
+// CPU-side model produced by the importer (owns all of its data)
+struct ModelData
+{
+	std::vector<MeshData> meshes;
+	// compressed bytes of the scene's embedded textures (empty if unused/raw)
+	std::vector<std::vector<unsigned char>> embeddedTextures;
+	glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
+
+	// Builds a view over this data (valid as long as the ModelData lives)
+	ModelView view() const {
+		ModelView v;
+		v.aabbMin = aabbMin;
+		v.aabbMax = aabbMax;
+		for (const MeshData& m : meshes) {
+			MeshView mv;
+			mv.format = m.format;
+			if (m.format == VertexFormat::Packed) {
+				mv.packedVertices = m.packedVertices.data();
+				mv.colors = m.colors.empty() ? nullptr : m.colors.data();
+				mv.vertexCount = m.packedVertices.size();
+			}
+			else {
+				mv.vertices = m.vertices.data();
+				mv.vertexCount = m.vertices.size();
+			}
+			mv.indices = m.indices.data();
+			mv.indexCount = m.indices.size();
+			mv.lods = m.lods.empty() ? nullptr : m.lods.data();
+			mv.lodCount = m.lods.size();
+			mv.meshlets = m.meshlets.empty() ? nullptr : m.meshlets.data();
+			mv.meshletCount = m.meshlets.size();
+			mv.aabbMin = m.aabbMin;
+			mv.aabbMax = m.aabbMax;
+			mv.diffuse = m.diffuse;
+			mv.specular = m.specular;
+			v.meshes.push_back(mv);
+		}
+		for (const auto& bytes : embeddedTextures) {
+			v.embeddedTextures.push_back({ bytes.data(), bytes.size() });
+		}
+		return v;
+	}
+};
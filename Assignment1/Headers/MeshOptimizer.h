@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include "MeshData.h"
+
+// Post-import index/vertex reordering (runs on the float vertices, before packing):
+// 1. Tipsify (Sander et al. 2007) for post-transform vertex cache locality
+// 2. view-independent overdraw sort of the clusters Tipsify produced
+// 3. vertex remap so the vertex fetch follows the index order
+class MeshOptimizer
+{
+public:
+	// FIFO size assumed for the post-transform cache
+	static const unsigned int CACHE_SIZE = 16;
+
+	// ACMR: cache misses per triangle (0.5 is ideal, 3 is worst)
+	// ATVR: cache misses per vertex (1.0 is ideal)
+	struct Stats {
+		float acmr = 0.0f;
+		float atvr = 0.0f;
+	};
+
+	// Simulates a FIFO cache of cacheSize entries over the index buffer
+	static Stats Analyze(const GLuint* indices, size_t indexCount, size_t vertexCount,
+		unsigned int cacheSize = CACHE_SIZE);
+
+	// Runs all three passes on a triangle mesh, returns the stats before and after
+	static void Optimize(MeshData& mesh, Stats& before, Stats& after);
+
+	// Reorders triangles in place, returns the first triangle of every cluster
+	static std::vector<size_t> Tipsify(std::vector<GLuint>& indices, size_t vertexCount,
+		unsigned int cacheSize = CACHE_SIZE);
+	// Sorts clusters so outward facing ones are drawn first. Keeps the Tipsify
+	// order if the cache efficiency would drop by more than threshold (1.05 = 5%).
+	static void OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+		const std::vector<size_t>& clusters, float threshold = 1.05f);
+	// Renumbers vertices in order of first use, dropping unreferenced ones
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+#include "MeshData.h"
+
+// Edge-collapse simplifier driven by quadric error metrics (Garland & Heckbert).
+// Vertices are only ever collapsed onto existing neighbours, so every LOD
+// reuses the original vertex buffer and just needs its own index range.
+// Attribute seams (same position, different normal/UV) are locked and mesh
+// borders may only collapse along themselves, with extra border quadrics
+// keeping their shape.
+class MeshSimplifier
+{
+public:
+	// LOD0 plus up to this many coarser levels in total
+	static const size_t MAX_LODS = 5;
+
+	// Simplifies towards targetIndexCount without exceeding targetError (mesh units).
+	// Returns the new index list, resultError gets the error actually reached.
+	static std::vector<GLuint> Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+		size_t targetIndexCount, float targetError, float& resultError);
+
+	// Appends halving LODs after mesh.indices and fills mesh.lods.
+	// maxError is relative to the mesh's AABB diagonal.
+	static void BuildLods(MeshData& mesh, size_t maxLods = MAX_LODS, float maxError = 0.05f);
+};
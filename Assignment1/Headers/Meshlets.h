@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "MeshData.h"
+#include "Frustum.h"
+
+// Splits a mesh's LOD0 into small clusters, each with a bounding sphere
+// and a normal cone, so whole clusters can be skipped before drawing.
+class MeshletBuilder
+{
+public:
+	static const size_t MAX_VERTICES = 64;
+	static const size_t MAX_TRIANGLES = 124;
+
+	// Partitions LOD0 in its current (cache optimized) triangle order and fills mesh.meshlets
+	static void Build(MeshData& mesh, size_t maxVertices = MAX_VERTICES, size_t maxTriangles = MAX_TRIANGLES);
+};
+
+// Per-frame CPU culling of one mesh's meshlets against the view frustum and
+// their normal cones. Bounds are stored as structure-of-arrays so SSE2 can
+// test four clusters at once; visible index ranges come out ready for
+// glMultiDrawElements, with neighbouring ranges merged.
+class ClusterCuller
+{
+public:
+	// global switch (ImGui)
+	static bool enabled;
+	// clusters tested / drawn since the last ResetStats
+	static size_t tested;
+	static size_t visible;
+	static void ResetStats();
+
+	ClusterCuller() = default;
+	ClusterCuller(const Meshlet* meshlets, size_t count);
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+
+	// frustum and cameraPos must be in mesh space (the cone test assumes uniform scale)
+	void Cull(const Frustum& frustum, const glm::vec3& cameraPos,
+		std::vector<GLsizei>& counts, std::vector<const void*>& offsets, bool simd = true) const;
+
+	// Culls clusterCount random clusters on the CPU only, prints SIMD vs scalar timings
+	static void Benchmark(size_t clusterCount, int iterations);
+
+private:
+	size_t count = 0;
+	// bounds, padded to a multiple of 4 with clusters that are always culled
+	std::vector<float> cx, cy, cz, radius;
+	std::vector<float> ax, ay, az, cutoff;
+	std::vector<uint32_t> firstIndex, indexCount;
+
+	// visibility of clusters [begin, begin + 4) as a 4-bit mask
+	unsigned int testSimd(size_t begin, const Frustum& frustum, const glm::vec3& cameraPos) const;
+	bool testScalar(size_t i, const Frustum& frustum, const glm::vec3& cameraPos) const;
+	void emit(size_t i, std::vector<GLsizei>& counts, std::vector<const void*>& offsets) const;
+};
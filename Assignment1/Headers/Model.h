@@ -4,13 +4,15 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp> 
 #include "Mesh.h"
+#include "AssetCache.h"
+#include "ModelLoader.h"
+#include "AabbCuller.h"
 class Shader;
+class Camera;
+class RenderQueue;
 
 class Model
 {
@@ -19,6 +21,9 @@ public:
     explicit Model(const std::string& path);
     Model(const std::string& path, const std::vector<std::string>& skipNames);
     Model(const std::string& path, const std::string& diffusePath, const std::string& specularPath);
+    Model(const std::string& path, const ModelOptions& options);
+    // model that appears once a background load finishes (see ModelLoader::LoadAsync)
+    explicit Model(std::shared_ptr<PendingModel> pending);
 
     // Prevent copying
     Model(const Model&) = delete;
@@ -35,14 +40,30 @@ public:
             * glm::scale(glm::mat4(1.0f), scale);
     }
 
-    // axis-aligned bounding box (model space)
-    glm::vec3 getAABBMin() const { return aabbMin; }
-    glm::vec3 getAABBMax() const { return aabbMax; }
-    glm::vec3 getAABBCenter() const { return (aabbMin + aabbMax) * 0.5f; }
-    glm::vec3 getAABBSize() const { return (aabbMax - aabbMin); }
+    // axis-aligned bounding box (model space, zero while still loading)
+    glm::vec3 getAABBMin() const { return asset ? asset->aabbMin : glm::vec3(0.0f); }
+    glm::vec3 getAABBMax() const { return asset ? asset->aabbMax : glm::vec3(0.0f); }
+    glm::vec3 getAABBCenter() const { return (getAABBMin() + getAABBMax()) * 0.5f; }
+    glm::vec3 getAABBSize() const { return (getAABBMax() - getAABBMin()); }
+
+    // false while a background load is still running
+    bool isLoaded();
+    // the shared asset (nullptr while loading)
+    std::shared_ptr<ModelAsset> getAsset() { return isLoaded() ? asset : nullptr; }
 
     // draw the model's meshes
     void Draw(Shader& shader);
+    // same, with each mesh's LOD picked from the model's projected size
+    void Draw(Shader& shader, const Camera& camera);
+    // adds the meshes to a render queue instead of drawing them (same LOD and culling choices)
+    void Submit(RenderQueue& queue, Shader& shader, const Camera& camera, int material = 0);
+
+    // allowed LOD error in pixels (shared by all models)
+    static float lodPixelError;
+    // highest LOD used by the last camera draw
+    size_t lastLod() const { return drawnLod; }
+    // false if the last camera draw culled the whole model
+    bool wasVisible() const { return visibleLastDraw; }
 
 private:
     // local transform
@@ -50,23 +71,19 @@ private:
     glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);  // Identity quaternion
     glm::vec3 scale = glm::vec3(1.0f);
 
-    // model space bounds
-    glm::vec3 aabbMin = glm::vec3(std::numeric_limits<float>::max());
-    glm::vec3 aabbMax = glm::vec3(-std::numeric_limits<float>::max());
-
-	// the shared asset data
-    std::vector<std::shared_ptr<Mesh>> meshes;
-    std::string diffusePath;
-    std::string specularPath;
-
-    // Skip some unwanted meshes
-    std::vector<std::string> meshNameSkips;
-    bool shouldSkipMesh(const std::string& name) const;
+	// the shared asset data (meshes, textures, bounds)
+    std::shared_ptr<ModelAsset> asset;
+    // set while the asset is still being loaded in the background
+    std::shared_ptr<PendingModel> pending;
+    size_t drawnLod = 0;
+    bool visibleLastDraw = true;
+    // world space mesh boxes and their visibility, rebuilt every camera draw
+    AabbCuller meshBounds;
+    std::vector<unsigned char> meshVisible;
 
-	// procedure to load model
-    void loadModel(const std::string& path);
-    void processNode(aiNode* node, const aiScene* scene);
-    std::shared_ptr<Mesh> processMesh(aiMesh* mesh, const aiScene* scene);
-    void AttachTextures(std::vector<std::shared_ptr<Texture>>& textures,
-        aiMaterial* material, const aiScene* scene);
+    // pixels covered by one model unit at the model's closest point
+    float pixelsPerUnit(const Camera& camera, const glm::mat4& computedMatrix) const;
+    // frustum culls the model box, then the mesh boxes (fills meshVisible);
+    // false if nothing is visible
+    bool cullMeshes(const Camera& camera, const glm::mat4& computedMatrix);
 };
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <assimp/scene.h>
+#include "AssetCache.h"
+#include "MeshData.h"
+
+// Options that change what an import produces (part of the cache key)
+struct ModelOptions
+{
+	// Skip some unwanted meshes
+	std::vector<std::string> skipNames;
+	// Force diffuse/specular textures when the file has none
+	std::string diffusePath;
+	std::string specularPath;
+	// Reorder indices/vertices for the vertex cache, overdraw and fetch (MeshOptimizer)
+	bool optimizeMeshes = true;
+	// Build a simplified LOD chain per mesh (MeshSimplifier)
+	bool generateLods = true;
+	// Split LOD0 into meshlets for cluster culling (MeshletBuilder)
+	bool buildMeshlets = true;
+	// Store vertices as PackedVertex (16 bytes) instead of Vertex (44 bytes)
+	bool packVertices = true;
+
+	// key identifying an asset: same file + same options = same data
+	std::string cacheKey(const std::string& path, unsigned int flags) const;
+};
+
+// Future-like handle to a model that is being loaded in the background
+class PendingModel
+{
+public:
+	enum State { Loading, Ready, Failed };
+
+	bool IsReady() const { return state == Ready; }
+	bool HasFailed() const { return state == Failed; }
+	// The loaded asset (nullptr until IsReady)
+	std::shared_ptr<ModelAsset> get() const { return IsReady() ? asset : nullptr; }
+	const std::string& path() const { return sourcePath; }
+
+private:
+	friend class ModelLoader;
+	std::atomic<int> state{ Loading };
+	std::shared_ptr<ModelAsset> asset;
+	std::string sourcePath;
+};
+
+// Turns model files into ModelAssets. The CPU side (bake/Assimp import,
+// conversion) can run on the thread pool, while everything touching GL is
+// queued and drained by the render thread under a time budget. Textures
+// are handed to the TextureStreamer, which decodes them in parallel.
+class ModelLoader
+{
+public:
+	// Assimp post-processing used for every import
+	static const unsigned int IMPORT_FLAGS;
+
+	static ModelLoader& Instance();
+
+	// Blocking load, must be called on the GL thread
+	std::shared_ptr<ModelAsset> Load(const std::string& path, const ModelOptions& options);
+	// Background load, returns immediately (GL thread only)
+	std::shared_ptr<PendingModel> LoadAsync(const std::string& path, const ModelOptions& options);
+	// Runs queued GL uploads until budgetMs is used up (always at least one step)
+	void ProcessUploads(double budgetMs);
+	// Number of loads that are not finished yet
+	size_t pendingLoads() const { return inFlight.size(); }
+
+private:
+	struct LoadJob;
+
+	// jobs whose CPU stage finished, waiting for the GL thread
+	std::mutex readyMutex;
+	std::deque<std::shared_ptr<LoadJob>> readyJobs;
+	// loads started but not finished, so duplicate requests share one job
+	std::unordered_map<std::string, std::shared_ptr<PendingModel>> inFlight;
+
+	// CPU stage (any thread)
+	static void runCpuStage(LoadJob& job);
+	static bool importModel(LoadJob& job);
+	static void processNode(aiNode* node, const aiScene* scene, const ModelOptions& options, ModelData& data);
+	static MeshData processMesh(aiMesh* mesh, const aiScene* scene, const ModelOptions& options);
+	static void AttachTextures(MeshData& meshData, aiMaterial* material, const aiScene* scene,
+		const ModelOptions& options);
+	static std::string textureKey(const TextureRef& ref, const std::string& modelPath, const char* typeName);
+
+	// GL stage (render thread), returns true once every mesh is uploaded
+	static bool uploadNext(LoadJob& job);
+	static std::shared_ptr<Texture> acquireTexture(LoadJob& job, const TextureRef& ref,
+		const char* typeName, GLuint slot);
+	void finish(LoadJob& job);
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <glad/glad.h>
+
+// CPU/GPU frame profiler. Zones nest and are timed on the CPU with a steady
+// clock and on the GPU with GL_TIMESTAMP queries. Query results are read two
+// frames later, and only once they are available, so the profiler never
+// waits on the GPU (a frame whose results are still pending is shown without
+// GPU times instead).
+//
+//     Profiler::Instance().BeginFrame();
+//     { ProfileZone zone("Shadows"); ... }
+//     Profiler::Instance().EndFrame();
+class Profiler
+{
+public:
+	// frames of history kept per zone for the statistics and graph
+	static const int HISTORY = 240;
+	// frames whose GPU queries may be in flight
+	static const int LATENCY = 2;
+
+	static Profiler& Instance();
+
+	// global switch (ImGui), zones are free while it is off
+	static bool enabled;
+
+	// Prevent copying
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void BeginFrame();
+	void EndFrame();
+	// Zones must be closed in reverse order, ProfileZone does this.
+	// false (and nothing to close) outside a frame or while disabled.
+	bool BeginZone(const char* name, bool gpu = true);
+	void EndZone();
+
+	// Panel with the frame-time graph, flame timeline and per-zone statistics
+	void DrawGUI();
+	// Deletes the queries, call while the context is alive
+	void Delete();
+
+	// frames whose GPU times were dropped because the queries were not ready
+	size_t dropped = 0;
+
+	struct Stats {
+		float min = 0.0f, avg = 0.0f, p95 = 0.0f, p99 = 0.0f;
+	};
+
+private:
+	Profiler();
+
+	struct Zone {
+		const char* name;
+		int depth;
+		double cpuBegin, cpuEnd;        // ms from the start of the frame
+		int gpuBegin = -1, gpuEnd = -1; // query indices, -1 without GPU timing
+		double gpuBeginMs = 0.0, gpuEndMs = 0.0;
+	};
+
+	// one frame's zones and the queries that time them
+	struct Frame {
+		std::vector<Zone> zones;
+		std::vector<GLuint> queries;
+		int usedQueries = 0;
+		bool pending = false;
+		double cpuMs = 0.0;
+		double gpuMs = 0.0;
+		bool hasGpu = false;
+	};
+
+	// rolling samples of one zone (ms), -1 marks a missing GPU sample
+	struct History {
+		const char* name;
+		float cpu[HISTORY];
+		float gpu[HISTORY];
+	};
+
+	int timestamp(Frame& frame);
+	void resolve(Frame& frame);
+	void record(const Frame& frame);
+	History& historyFor(const char* name);
+	static Stats computeStats(const float* samples);
+	void drawTimeline(const Frame& frame, bool gpu);
+
+	Frame frames[LATENCY];
+	int current = 0;
+	bool inFrame = false;
+	double frameStart = 0.0;
+	std::vector<int> stack;
+
+	// last frame with resolved results, drawn in the timeline
+	Frame shown;
+	std::vector<History> histories;
+	float frameCpu[HISTORY];
+	float frameGpu[HISTORY];
+	int historyHead = 0;
+	bool paused = false;
+	int statsSource = 0; // 0 CPU, 1 GPU
+};
+
+// Times the enclosing scope as a profiler zone
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name, bool gpu = true);
+	~ProfileZone();
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	bool active;
+};
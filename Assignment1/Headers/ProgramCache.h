@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are
+// keyed by a hash of the shader sources, the defines and the driver's vendor,
+// renderer and version strings, so a driver update or an edited shader just
+// misses. A binary the driver rejects falls back to compiling from source.
+class ProgramCache
+{
+public:
+	// bump whenever the file layout changes
+	static const uint32_t VERSION = 1;
+	// directory the binaries are written to (relative to the working dir)
+	static const char* DIRECTORY;
+
+	// Cache key of a program built from these sources (needs a current context)
+	static uint64_t Key(const std::string& vertexSource, const std::string& fragmentSource,
+		const std::string& defines);
+	// Loads the cached binary into program; false if missing or rejected,
+	// the program must then be rebuilt from source
+	static bool Load(uint64_t key, GLuint program);
+	// Stores a linked program (linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+	static bool Save(uint64_t key, GLuint program);
+
+	// loads served from disk / built from source / binaries the driver refused
+	static size_t hits;
+	static size_t misses;
+	static size_t rejected;
+
+private:
+	static std::string cachePath(uint64_t key);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+// Settings of a regression run, from the command line:
+//     --regression [--update] [--refs dir] [--tolerance dE] [--slack fraction]
+struct RegressionOptions
+{
+	bool enabled = false;
+	// store the current images and budgets as the new references
+	bool update = false;
+	std::string directory = "Regression";
+	// per-pixel CIE76 colour difference that still counts as the same pixel
+	float tolerance = 4.0f;
+	// fraction of pixels allowed above the tolerance
+	float maxBadPixels = 0.002f;
+	// allowed frame-time growth over the recorded budget
+	float slack = 0.15f;
+
+	static RegressionOptions Parse(int argc, char** argv);
+};
+
+// Golden-image and performance checks for headless renders. Images are RGBA8
+// from FBO::ReadPixels and are stored as binary PPM (<dir>/<name>.ppm). A
+// failing image is written to <dir>/failed with a difference heat map. The
+// frame-time and draw-call budgets live in <dir>/budget.json.
+class RegressionSuite
+{
+public:
+	explicit RegressionSuite(const RegressionOptions& options);
+	// true when storing new references instead of checking
+	bool updating() const { return options.update; }
+
+	// Compares a render against its reference (or stores it with --update)
+	bool CheckImage(const std::string& name, const std::vector<unsigned char>& rgba, int width, int height);
+	// Compares a measured p95 frame time and draw count against the budget
+	bool CheckBudget(const std::string& name, double frameMs, size_t drawCalls);
+	// Writes the budget file when updating, prints the summary; true if all checks passed
+	bool Finish();
+
+	// Mean CIE76 difference and fraction of pixels above the tolerance (RGB8 images)
+	static void Compare(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b,
+		float tolerance, double& meanDelta, double& badFraction, std::vector<unsigned char>* heatMap);
+
+	// Binary PPM (P6) helpers, RGB8 top row first
+	static bool ReadPPM(const std::string& path, std::vector<unsigned char>& rgb, int& width, int& height);
+	static bool WritePPM(const std::string& path, const std::vector<unsigned char>& rgb, int width, int height);
+
+private:
+	struct Budget {
+		double frameMs;
+		size_t drawCalls;
+	};
+
+	RegressionOptions options;
+	std::map<std::string, Budget> budgets;
+	std::map<std::string, Budget> measured;
+	int passed = 0;
+	int failed = 0;
+
+	std::string budgetPath() const { return options.directory + "/budget.json"; }
+	void loadBudgets();
+	bool fail(const std::string& name, const std::string& reason);
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+#include "GLExt.h"
+#include "GeometryPool.h"
+class Shader;
+class Mesh;
+
+// Collects the frame's draws, sorts them by a 64-bit key and executes them
+// in that order. Keys are laid out most significant first:
+//
+//   63-62  pass       opaque before transparent
+//   61-52  shader     program ID, fewest program switches
+//   51-40  material   texture set and material index
+//   39-24  mesh       vertex array, consecutive draws of one mesh share binds
+//   23-0   depth      front to back (back to front for transparent)
+//
+// The sort is an LSD radix sort over the 8 key bytes. With multi-draw
+// indirect available, consecutive draws sharing a shader, vertex layout and
+// texture set are issued as one glMultiDrawElementsIndirect from their
+// GeometryPool; otherwise every draw goes through Mesh::Draw.
+class RenderQueue
+{
+public:
+	enum Pass { Opaque = 0, Transparent = 1 };
+
+	// What is sorted: the key plus the index of its command
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t command;
+	};
+
+	// Packs the fields above (each one is masked to its width)
+	static uint64_t MakeKey(Pass pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth);
+
+	// Adds one mesh draw; depth is the view distance of the mesh. A shader
+	// that is still compiling is replaced by its fallback (Shader::Resolve).
+	void Submit(Pass pass, Shader& shader, Mesh& mesh, const glm::mat4& model, float depth,
+		size_t lod = 0, int material = 0);
+	// Same, drawing only the LOD0 clusters that survive culling (frustum/camera in mesh space)
+	void SubmitClusters(Pass pass, Shader& shader, Mesh& mesh, const glm::mat4& model, float depth,
+		const Frustum& frustum, const glm::vec3& localCamera, int material = 0);
+
+	// Sorts the submitted draws by key
+	void Sort();
+	// Issues the draws in sorted order (batched if multiDraw and supported)
+	void Execute();
+	// Empties the queue (keeps the memory)
+	void Clear();
+	size_t size() const { return commands.size(); }
+
+	// Program and mesh changes and GL draw calls in the last Execute
+	size_t shaderSwitches = 0;
+	size_t meshSwitches = 0;
+	size_t drawCalls = 0;
+
+	// Use glMultiDrawElementsIndirect batches when the context has them. Off by
+	// default until --regression shows they match the direct path; the GUI
+	// can switch it on.
+	static bool multiDraw;
+
+	// Sorts items by key, scratch is resized to match
+	static void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+	// Sorts count random keys with RadixSort and std::sort and prints the timings
+	static void Benchmark(size_t count, int iterations);
+
+private:
+	struct Command
+	{
+		Shader* shader;
+		Mesh* mesh;
+		glm::mat4 model;
+		size_t lod;
+		int material;
+		bool clusters;
+		Frustum frustum;
+		glm::vec3 localCamera;
+	};
+
+	std::vector<Command> commands;
+	std::vector<SortItem> items;
+	std::vector<SortItem> scratch;
+
+	// batch being collected by executeBatched
+	Shader* batchShader = nullptr;
+	Mesh* batchMesh = nullptr; // first mesh, its textures are bound for the batch
+	GeometryPool* batchPool = nullptr;
+	std::vector<DrawElementsIndirectCommand> batchCommands;
+	std::vector<DrawData> batchDraws;
+	// cluster culling output
+	std::vector<GLsizei> cullCounts;
+	std::vector<const void*> cullOffsets;
+
+	void add(Pass pass, const Command& command, float depth);
+	// one Mesh::Draw per command
+	void executeDirect();
+	// commands merged into multi-draws per pool
+	void executeBatched();
+	void flushBatch();
+	// activates the shader if it differs from the last one
+	void useShader(Shader*& current, Shader* shader);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <glad/glad.h>
+#include "VBO.h"
+
+// Triple-buffered stream of per-frame GPU data (per-draw attributes,
+// indirect commands, uniform blocks). The buffer is split into one section
+// per frame in flight. A frame writes only into its own section, and a fence
+// keeps a section from being reused while the GPU may still read it.
+//
+// With buffer storage the whole buffer is mapped once, persistent and
+// coherent, and writes land in GPU visible memory directly. Without it,
+// writes are staged on the CPU, Flush uploads them, and a single section
+// is orphaned every frame (the driver keeps the old storage for the GPU).
+class RingBuffer
+{
+public:
+	static const int FRAMES = 3;
+	static const size_t FRAME_SIZE = 8u * 1024u * 1024u;
+
+	// The shared per-frame ring (created on first use, needs a context)
+	static RingBuffer& Shared();
+
+	explicit RingBuffer(size_t frameSize);
+	~RingBuffer();
+
+	// Prevent copying
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	// Waits until this frame's section is no longer read by the GPU
+	void BeginFrame();
+	// Reserves size bytes in this frame's section; offset is from the start of
+	// the buffer and a multiple of alignment (any value, not only powers of two).
+	// nullptr if the section is full.
+	void* Allocate(size_t size, size_t alignment, size_t& offset);
+	// Makes everything written since the last Flush visible to GL (no-op when persistent)
+	void Flush();
+	// Allocates, copies and flushes; returns false if the section is full
+	bool Write(const void* data, size_t size, size_t alignment, size_t& offset);
+	// Fences this frame's section and moves on to the next one
+	void EndFrame();
+	// Deletes the buffer, call while the context is alive
+	void Delete();
+
+	// the buffer object, bind it to whatever target the data is for
+	VBO& buffer() { return *vbo; }
+	bool persistent() const { return mapped != nullptr; }
+	// required offset alignment for glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+	size_t uniformAlignment() const { return uniformAlign; }
+
+	// bytes used by the last finished frame, BeginFrames that had to wait
+	size_t lastFrameBytes = 0;
+	size_t stalls = 0;
+
+private:
+	size_t frameSize;
+	int frame = 0;
+	size_t head = 0;     // next free byte, relative to the section
+	size_t flushed = 0;  // staged bytes already uploaded (fallback)
+	GLsync fences[FRAMES] = {};
+	std::unique_ptr<VBO> vbo;
+	unsigned char* mapped = nullptr;
+	// fallback: this frame's section on the CPU
+	std::vector<unsigned char> staging;
+	size_t uniformAlign = 256;
+	bool reportedFull = false;
+
+	size_t sectionBase() const;
+};
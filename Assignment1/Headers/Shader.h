@@ -4,15 +4,76 @@
 #include<string>
 #include <glm/glm.hpp>     // glm::mat4 support
 #include <unordered_map>   // cache
+#include <cstdint>
+#include <vector>
+#include <memory>
 
 std::string get_file_contents(const char* filename);
 
+// A compiled shader object, shared by every program built from the same
+// stage source (e.g. scene.vert under all lighting variants). Stages are
+// found by type and source and deleted with the last program holding them.
+class ShaderStage {
+public:
+	GLuint ID = 0;
+	GLenum type;
+
+	// The stage compiled from this source, compiling it only if no live
+	// program holds one already
+	static std::shared_ptr<ShaderStage> Get(GLenum type, const std::string& source);
+	// Compile status, errors are printed the first time only
+	bool Check();
+
+	// stages compiled / requests served by an existing stage
+	static size_t compiled;
+	static size_t shared;
+
+	ShaderStage(GLenum type, const std::string& source);
+	~ShaderStage();
+
+	// Prevent copying (avoid double-delete)
+	ShaderStage(const ShaderStage&) = delete;
+	ShaderStage& operator=(const ShaderStage&) = delete;
+
+private:
+	bool checked = false;
+	bool compiledOk = false;
+};
+
 class Shader {
 public:
-	// Reference ID of the Shader Program
-	GLuint ID;
-	// Constructor that build the Shader Program from 2 different shaders
-	Shader(const char* vertexFile, const char* fragmentFile);
+	// Reference ID of the Shader Program (0 until the first build links)
+	GLuint ID = 0;
+	// Constructor that build the Shader Program from 2 different shaders;
+	// defines ("#define NAME ...\n" lines) go right after #version in each
+	// stage whose source mentions NAME, and #include "file" lines are replaced
+	// by the file's contents. Stages with the same final source are compiled
+	// once (ShaderStage). The linked
+	// program is cached on disk (ProgramCache) and reused by later runs.
+	// An async build only submits the compile and link and returns at once.
+	Shader(const char* vertexFile, const char* fragmentFile, const std::string& defines = "", bool async = false);
+
+	// True once the build finished (async builds poll GL_COMPLETION_STATUS_KHR
+	// and don't wait; without parallel compile this waits for the driver)
+	bool IsReady();
+	// True if the finished build had compile or link errors and there is no
+	// earlier program to keep
+	bool failed() const { return buildFailed; }
+	// True while ID holds a linked program (right after construction on a
+	// program cache hit)
+	bool linked() const { return usable; }
+	// Rebuilds from the same files like an async build. The current program
+	// stays in use until the new one links (then ID changes and the uniform
+	// cache is cleared), and is kept if the new one fails. Program state such
+	// as sampler units and block bindings has to be set again after the swap.
+	void Reload();
+	// Every file the program was built from, includes too
+	const std::vector<std::string>& sources() const { return sourceFiles; }
+	// Program to draw with right now: this one, or the fallback while it is
+	// still building (or failed). Doesn't poll, IsReady does that.
+	Shader& Resolve();
+	// Stand-in used by Resolve, must have the same vertex stage
+	Shader* fallback = nullptr;
 
 	// Activates the Shader Program
 	void Activate();
@@ -31,8 +92,17 @@ public:
 	//void setVec4(const std::string& name, float x, float y, float z, float w) const;
 	void setVec4(const std::string& name, const glm::vec4& v) const;
 
+	// Sets "model" and its "normalMatrix"
+	void setModelMatrix(const glm::mat4& model) const;
+	// Inverse transpose of the upper 3x3 (up to scale, the shader normalizes);
+	// rotation + uniform scale skips the inverse
+	static glm::mat3 NormalMatrix(const glm::mat4& model);
+
+	// Points a uniform block at a buffer binding point (no-op if the block is unused)
+	void BindUniformBlock(const char* blockName, GLuint binding) const;
+
 	~Shader() {
-		if (ID != 0) Delete();
+		if (ID != 0 || building != 0) Delete();
 	}
 
 	// Prevent copying (avoid double-delete)
@@ -43,6 +113,27 @@ private:
 	// cache of uniform locations to reduce calls
 	mutable std::unordered_map<std::string, GLint> uniformCache;
 	GLint getUniformLocation(const std::string& name) const;
-	// error handler
-	void checkCompileErrors(GLuint shader, const std::string& type);
+	// error handler, false if compiling/linking failed
+	bool checkCompileErrors(GLuint shader, const std::string& type);
+
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::string defines;
+	std::vector<std::string> sourceFiles;
+
+	// ID holds a linked program
+	bool usable = false;
+	bool buildFailed = false;
+	// build submitted but not checked yet
+	GLuint building = 0;
+	std::shared_ptr<ShaderStage> buildVertex;
+	std::shared_ptr<ShaderStage> buildFragment;
+	// stages of the current program, kept so later programs can share them
+	std::shared_ptr<ShaderStage> vertexStage;
+	std::shared_ptr<ShaderStage> fragmentStage;
+	uint64_t cacheKey = 0;
+	void submitBuild();
+	void finishBuild();
+	void adopt(GLuint program);
+	void cancelBuild();
 };
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Shader.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Lighting features, OR'd together into the key of a variant. Each set bit
+// becomes "#define FEATURE_..." in the shader source.
+enum ShaderFeature : uint32_t {
+	FEATURE_TOON = 1u << 0,          // toon bands (no model bit: Blinn-Phong)
+	FEATURE_COOK_TORRANCE = 1u << 1, // GGX microfacet model
+	FEATURE_TEXTURES = 1u << 2,      // diffuse0/specular0 instead of vertex colors
+	FEATURE_RIM = 1u << 3,           // toon rim lighting
+};
+
+// Permutations of one vertex and one fragment source. A variant is built
+// (async, drawing with the fallback meanwhile) the first time it is asked
+// for and kept from then on; all variants share the compiled vertex stage.
+//
+//     Shader& toon = variants.Get(FEATURE_TOON | FEATURE_RIM);
+class ShaderVariants
+{
+public:
+	ShaderVariants(const char* vertexFile, const char* fragmentFile, Shader* fallback = nullptr);
+
+	// Prevent copying (owns the programs)
+	ShaderVariants(const ShaderVariants&) = delete;
+	ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+	// The variant for a feature mask, its build starts on the first request
+	Shader& Get(uint32_t features);
+	// Variants created since the last call, to configure once they link
+	std::vector<Shader*> TakeNew();
+	// "#define FEATURE_...\n" lines of a feature mask
+	static std::string Defines(uint32_t features);
+
+	// Program state to set on a variant that links inside Get (a program cache
+	// hit). glProgramBinary doesn't restore block bindings, so without this
+	// such a variant would be drawn unconfigured before the owner sees it.
+	std::function<void(Shader&)> configure;
+
+	size_t size() const { return variants.size(); }
+	// Deletes every variant, call while the context is alive
+	void Delete();
+
+private:
+	std::string vertexPath;
+	std::string fragmentPath;
+	Shader* fallback;
+	std::map<uint32_t, std::unique_ptr<Shader>> variants;
+	std::vector<Shader*> created;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ctime>
+#include <chrono>
+class Shader;
+
+// Watches the source files of shaders (includes too) and reports the shaders
+// whose files were written. On Linux this uses inotify on the directories
+// (editors often save by renaming a temp file over the original); elsewhere,
+// or if inotify is unavailable, file times are compared a few times a second.
+class ShaderWatcher
+{
+public:
+	ShaderWatcher();
+	~ShaderWatcher();
+
+	// Prevent copying (owns the inotify descriptor)
+	ShaderWatcher(const ShaderWatcher&) = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// Starts watching the shader's current sources; call again after a reload
+	// to pick up newly included files
+	void Watch(Shader& shader);
+	// Shaders with a source file written since the last call (never blocks)
+	std::vector<Shader*> Poll();
+
+private:
+	std::vector<Shader*> shaders;
+	// inotify descriptor, -1 when polling file times
+	int notifyFd = -1;
+	// watch descriptor -> directory
+	std::unordered_map<int, std::string> directories;
+	// fallback: last seen write time per file
+	std::unordered_map<std::string, std::time_t> writeTimes;
+	std::chrono::steady_clock::time_point lastCheck;
+
+	void watchDirectory(const std::string& directory);
+	std::vector<std::string> changedFiles();
+};
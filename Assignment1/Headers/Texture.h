@@ -1,7 +1,21 @@
 #pragma once
 
 #include<glad/glad.h>
+#include<cstddef>
+#include<vector>
 class Shader;
+struct CompressedImage;
+
+// Decoded image pixels, produced without a GL context (safe on worker threads)
+struct ImageData
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	std::vector<unsigned char> pixels;
+
+	bool valid() const { return !pixels.empty(); }
+};
 
 class Texture
 {
@@ -12,6 +26,10 @@ public:
 	Texture(const char* image, const char* texType, GLuint slot, GLenum pixelType);
 	// for embedded textures:
 	Texture(const unsigned char* data, size_t size, const char* texType, GLuint slot, GLenum pixelType);
+	// for images already decoded (e.g. on a loader thread):
+	Texture(const ImageData& image, const char* texType, GLuint slot, GLenum pixelType, GLenum filter = GL_LINEAR);
+	// for streamed textures: a 1x1 white placeholder until SetImage is called
+	Texture(const char* texType, GLuint slot);
 
 	~Texture() {
 		if (ID != 0) Delete();
@@ -21,6 +39,15 @@ public:
 	Texture(const Texture&) = delete;
 	Texture& operator=(const Texture&) = delete;
 
+	// Decodes an image file / an in-memory image (flipped for GL), no GL calls
+	static bool Decode(const char* image, ImageData& out);
+	static bool Decode(const unsigned char* data, size_t size, ImageData& out);
+
+	// (Re)defines the image; with an unpackBuffer (PBO), data is an offset into it
+	void SetImage(int width, int height, int channels, GLenum pixelType, const void* data, GLenum filter, GLuint unpackBuffer = 0);
+	// (Re)defines the image from pre-compressed blocks, one upload per stored mip
+	void SetCompressed(const CompressedImage& image, GLenum filter);
+
 	// Assigns a texture unit to a texture
 	void texUnit(Shader& shader, const char* uniform, GLuint unit);
 	// Binds a texture
@@ -29,4 +56,8 @@ public:
 	void Unbind();
 	// Deletes a texture
 	void Delete();
-};
\ No newline at end of file
+
+private:
+	// Creates the GL texture from decoded pixels
+	void upload(const ImageData& image, GLenum pixelType, GLenum filter);
+};
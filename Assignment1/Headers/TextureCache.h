@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "Texture.h"
+
+// Global cache of GPU textures so an image used by several meshes/models
+// is decoded and uploaded once. Entries are weak: a texture is freed as
+// soon as the last mesh using it goes away.
+class TextureCache
+{
+public:
+	static TextureCache& Instance();
+
+	// Keys (the type is part of the key since a Texture is tied to its slot)
+	static std::string KeyForFile(const std::string& path, const char* texType);
+	static std::string KeyForEmbedded(const std::string& modelPath, int index, const char* texType);
+
+	// Returns the live texture for key or nullptr, updates hit/miss stats (GL thread)
+	std::shared_ptr<Texture> Find(const std::string& key);
+	// True if key is currently loaded, no stats (safe from loader threads)
+	bool Contains(const std::string& key) const;
+	// Registers a freshly created texture
+	void Store(const std::string& key, const std::shared_ptr<Texture>& texture);
+	// Removes entries whose texture has already been released
+	void Prune();
+
+	// Simple stats
+	unsigned int hits = 0;
+	unsigned int misses = 0;
+	size_t size() const;
+
+private:
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, std::weak_ptr<Texture>> textures;
+};
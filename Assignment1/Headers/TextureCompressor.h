@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <glad/glad.h>
+#include "Texture.h"
+
+// GPU block-compression formats produced by TextureCompressor
+enum class BCFormat : uint32_t { BC1 = 1, BC4 = 4, BC5 = 5, BC7 = 7 };
+
+// Block-compressed image with its full mip chain (level 0 first)
+struct CompressedImage
+{
+	BCFormat format = BCFormat::BC1;
+	int width = 0;
+	int height = 0;
+	std::vector<std::vector<unsigned char>> levels;
+
+	bool valid() const { return !levels.empty(); }
+};
+
+// CPU texture encoder (BC1/BC4/BC5/BC7). Mips are generated with a box
+// filter and blocks are encoded in parallel on the shared thread pool,
+// with SSE2 used for the per-block endpoint searches.
+class TextureCompressor
+{
+public:
+	// Format for a texture role: diffuse -> BC7 (BC1 without BPTC),
+	// specular/roughness -> BC4, normal -> BC5. Needs GLExt::Load.
+	static BCFormat FormatForRole(const char* texType);
+	// True if the current context can sample this format
+	static bool Supported(BCFormat format);
+	static GLenum InternalFormat(BCFormat format);
+	static GLenum BaseFormat(BCFormat format);
+	static size_t BlockBytes(BCFormat format);
+	// Size in bytes of one mip level
+	static size_t LevelSize(BCFormat format, int width, int height);
+
+	// Compresses the image and all of its mips
+	static CompressedImage Compress(const ImageData& image, BCFormat format);
+
+	// Per-block encoders: 16 RGBA8 pixels (row-major 4x4) in, one block out
+	static void EncodeBC1(const unsigned char* rgba, unsigned char* out);
+	static void EncodeBC4(const unsigned char* rgba, int channel, unsigned char* out);
+	static void EncodeBC5(const unsigned char* rgba, unsigned char* out);
+	static void EncodeBC7(const unsigned char* rgba, unsigned char* out);
+
+	// Encodes a synthetic size x size image in every format and prints MPix/s
+	static void Benchmark(int size);
+};
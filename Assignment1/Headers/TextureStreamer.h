@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "Texture.h"
+#include "TextureCompressor.h"
+
+// Streams textures in: images are decoded on the thread pool, copied into
+// a pixel-unpack buffer ring and uploaded with glTexSubImage2D on the
+// render thread. Fences keep the ring from overwriting data the GPU is
+// still reading. Uses a persistently mapped ring when GL_ARB_buffer_storage
+// is available, unsynchronized glMapBufferRange otherwise.
+// With compressTextures set, workers transcode to BC1/4/5/7 instead (cached
+// as .ktx files) and the much smaller blocks are uploaded directly.
+class TextureStreamer
+{
+public:
+	// ring size in bytes (a 2K RGBA map is 16 MB)
+	static const size_t RING_SIZE = 64u * 1024u * 1024u;
+
+	static TextureStreamer& Instance();
+	~TextureStreamer();
+
+	// Block-compress textures on the workers (read at Request time)
+	bool compressTextures = true;
+
+	// Returns a placeholder texture that gets its pixels once decoded and uploaded.
+	// bytes is a compressed image in memory (copied), otherwise path is read.
+	std::shared_ptr<Texture> Request(const std::string& path, const char* texType, GLuint slot, GLenum filter);
+	std::shared_ptr<Texture> Request(const unsigned char* bytes, size_t size, const char* texType, GLuint slot, GLenum filter);
+
+	// Uploads decoded images until budgetMs is used up (render thread, once per frame)
+	void Update(double budgetMs);
+	// Blocks until everything requested so far is decoded and uploaded
+	void Flush();
+	// Releases the GL ring buffer (before the context goes away)
+	void Shutdown();
+
+	// Stats
+	size_t pendingCount() const { return pending.load(); }
+	unsigned int uploadedCount = 0;
+	// compressed textures found in / missing from the KTX cache
+	std::atomic<unsigned int> ktxHits{ 0 };
+	std::atomic<unsigned int> ktxMisses{ 0 };
+	// accumulated decode (and compress) time over all worker threads
+	double decodeMs() const;
+
+	// Decodes the files on threadCount workers without touching GL, returns wall time in ms
+	static double BenchmarkDecode(const std::vector<std::string>& paths, unsigned int threadCount);
+
+private:
+	struct Job;
+	struct Region {
+		size_t offset;
+		size_t size;
+		GLsync fence;
+	};
+
+	// decoded images waiting for upload
+	std::mutex readyMutex;
+	std::deque<std::shared_ptr<Job>> readyJobs;
+	std::atomic<size_t> pending{ 0 };
+	std::atomic<long long> decodeMicros{ 0 };
+
+	// pixel-unpack ring
+	GLuint pbo = 0;
+	unsigned char* mapped = nullptr; // persistent mapping, if any
+	size_t head = 0;
+	std::deque<Region> inFlight;
+
+	void submit(const std::shared_ptr<Job>& job);
+	// Worker side: KTX cache lookup, otherwise decode + compress + save
+	void transcode(Job& job);
+	void initRing();
+	// Finds room for size bytes, returns false if the GPU still uses it
+	bool allocate(size_t size, size_t& offset);
+	// Returns false if the ring has no free room yet
+	bool upload(Job& job);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads pulling jobs from a FIFO queue
+class ThreadPool
+{
+public:
+	// 0 = one worker per hardware thread, minus the main thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	// Prevent copying
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Queues a job to run on any worker
+	void Submit(std::function<void()> job);
+	// Blocks until the queue is empty and no job is running
+	void WaitIdle();
+	// Runs fn(0..count-1) across the workers and the calling thread. The caller
+	// helps instead of just waiting, so it is safe to use from inside a job.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+	unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+	// Shared pool for loading work (models, textures)
+	static ThreadPool& Shared();
+
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable jobReady;
+	std::condition_variable idle;
+	unsigned int running = 0;
+	bool stopping = false;
+
+	void workerLoop();
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+// CPU mirrors of the std140 uniform blocks shared by the scene shaders.
+// Member order and padding must match the GLSL declarations exactly.
+
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+
+// Fixed binding points, assigned to every program with Shader::BindUniformBlock
+const GLuint FRAME_BINDING = 0;
+const GLuint MATERIAL_BINDING = 1;
+
+// Must match MAX_MATERIALS in the fragment shaders
+const int MAX_MATERIALS = 16;
+
+// layout(std140) uniform Frame: camera and light, written once per frame
+struct FrameUniforms
+{
+	glm::mat4 camMatrix;   // proj * view
+	glm::vec3 camPos;
+	float ambient;         // fills the vec3's 16-byte slot
+	glm::vec4 lightColor;  // already scaled by intensity
+	glm::vec3 lightPos;
+	float padding;
+};
+static_assert(sizeof(FrameUniforms) == 112, "FrameUniforms must match the std140 Frame block");
+
+// One element of layout(std140) uniform Materials { Material materials[]; }.
+// Every lighting model reads the fields it needs.
+struct MaterialUniforms
+{
+	float specularStr = 0.5f;
+	float shininess = 32.0f;
+	float metallic = 0.0f;
+	float roughness = 0.5f;
+	GLint toonLevels = 3;
+	GLint enableRim = 0;   // GLSL bool is 4 bytes in std140
+	float rimStrength = 0.3f;
+	float padding = 0.0f;  // array stride is a multiple of 16
+};
+static_assert(sizeof(MaterialUniforms) == 32, "MaterialUniforms must match the std140 Material struct");
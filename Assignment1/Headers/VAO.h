@@ -20,6 +20,13 @@ public:
 
 	// Links a VBO to the VAO using a certain layout for float attributes
 	void LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLsizei stride, const void* offset);
+	// Same for any component type; normalized maps integers to [0,1] / [-1,1]
+	void LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLenum type, GLboolean normalized,
+		GLsizei stride, const void* offset);
+	// Links integer attributes (read as int/uint in the shader, no conversion)
+	void LinkVBOI(VBO& VBO, GLuint layout, GLint numComponents, GLenum type, GLsizei stride, const void* offset);
+	// Advances the attribute once per divisor instances instead of per vertex (vao must be bound)
+	void SetDivisor(GLuint layout, GLuint divisor);
 
 	// Binds the VAO
 	void Bind();
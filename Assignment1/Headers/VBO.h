@@ -3,6 +3,8 @@
 #include<glm/glm.hpp>
 #include<glad/glad.h>
 #include<vector>
+#include<cstdint>
+#include<cstddef>
 
 struct Vertex
 {
@@ -12,6 +14,17 @@ struct Vertex
 	glm::vec2 texUV;
 };
 
+// Compact vertex (16 bytes instead of 44): position quantized against the
+// mesh AABB, octahedral normal and half-float UVs. Vertex colors, if the
+// source has any, go in a separate RGBA8 stream after the vertices.
+struct PackedVertex
+{
+	uint16_t position[3]; // unorm16, 0..65535 spans aabbMin..aabbMax
+	uint16_t padding;     // keeps the normal 4-byte aligned
+	int16_t normal[2];    // snorm16 octahedral encoding
+	uint16_t texUV[2];    // half floats
+};
+
 class VBO
 {
 public:
@@ -19,6 +32,12 @@ public:
 	GLuint ID;
 	// Constructor that generates a Vertex Buffer Object and links it to vertices
 	VBO(const std::vector<Vertex>& vertices);
+	// Same, but from raw memory (e.g. a mapped cache file)
+	VBO(const Vertex* vertices, size_t count);
+	// Raw bytes of any layout (data may be nullptr to only allocate)
+	VBO(const void* data, size_t size);
+	// Immutable storage with glBufferStorage flags (needs GLExt::hasBufferStorage)
+	VBO(size_t size, GLbitfield storageFlags);
 	// Destructor
 	~VBO() {
 		if (ID != 0) Delete();
@@ -32,6 +51,8 @@ public:
 	void Bind();
 	// Unbinds the VBO
 	void Unbind();
+	// Overwrites part of the buffer
+	void Update(size_t offset, const void* data, size_t size);
 	// Deletes the VBO
 	void Delete();
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "MeshData.h"
+
+// Converts meshes to the compact PackedVertex layout, plus the scalar
+// encode/decode helpers it is built from (shared with scene.vert's math).
+class VertexPacker
+{
+public:
+	// Packs mesh.vertices into mesh.packedVertices (and colors if the source
+	// had any), then frees the float vertices. Uses mesh.aabbMin/aabbMax.
+	static void Pack(MeshData& mesh);
+
+	// Dequantization terms for the shader: position = q * scale + offset
+	static glm::vec3 PositionScale(const glm::vec3& aabbMin, const glm::vec3& aabbMax);
+	static glm::vec3 PositionOffset(const glm::vec3& aabbMin) { return aabbMin; }
+
+	// IEEE 754 binary16, round to nearest even
+	static uint16_t FloatToHalf(float value);
+	static float HalfToFloat(uint16_t half);
+	// Octahedral normal encoding into two snorm16 values
+	static void OctEncode(const glm::vec3& normal, int16_t out[2]);
+	static glm::vec3 OctDecode(const int16_t in[2]);
+};
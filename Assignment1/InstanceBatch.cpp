@@ -0,0 +1,100 @@
+#include "InstanceBatch.h"
+#include "Model.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "GLState.h"
+#include <cstddef>
+
+InstanceBatch::InstanceBatch(Model& source)
+	: model(source) {
+}
+
+InstanceBatch::~InstanceBatch() {
+	Delete();
+}
+
+void InstanceBatch::Clear() {
+	instances.clear();
+	dirty = true;
+}
+
+void InstanceBatch::Add(const glm::mat4& matrix, int materialIndex) {
+	InstanceData data = {};
+	data.model = matrix;
+	// computed once here instead of per vertex
+	glm::mat3 normal = Shader::NormalMatrix(matrix);
+	for (int col = 0; col < 3; col++) data.normalMatrix[col] = glm::vec4(normal[col], 0.0f);
+	data.materialIndex = materialIndex;
+	instances.push_back(data);
+	dirty = true;
+}
+
+void InstanceBatch::setup() {
+	std::shared_ptr<ModelAsset> asset = model.getAsset();
+	capacity = instances.size() > 0 ? instances.size() : 1;
+	instanceVbo.reset(new VBO(static_cast<const void*>(nullptr), capacity * sizeof(InstanceData)));
+
+	for (auto& mesh : asset->meshes) {
+		std::unique_ptr<VAO> vao(new VAO());
+		// the mesh's own vertex attributes (0-3) and EBO
+		mesh->LinkVertexLayout(*vao);
+
+		// model matrix: one vec4 column per location (4-7), advancing per instance
+		GLsizei stride = sizeof(InstanceData);
+		for (GLuint column = 0; column < 4; column++) {
+			vao->LinkVBO(*instanceVbo, 4 + column, 4, stride,
+				(void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+			vao->SetDivisor(4 + column, 1);
+		}
+		// normal matrix: one vec3 column per location (11-13)
+		for (GLuint column = 0; column < 3; column++) {
+			vao->LinkVBO(*instanceVbo, 11 + column, 3, stride,
+				(void*)(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec4)));
+			vao->SetDivisor(11 + column, 1);
+		}
+		// material index as a real integer
+		vao->LinkVBOI(*instanceVbo, 8, 1, GL_INT, stride, (void*)offsetof(InstanceData, materialIndex));
+		vao->SetDivisor(8, 1);
+
+		vao->Unbind();
+		vaos.push_back(std::move(vao));
+	}
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void InstanceBatch::upload() {
+	size_t bytes = instances.size() * sizeof(InstanceData);
+	instanceVbo->Bind();
+	// grow geometrically so adding instances doesn't reallocate every time
+	while (capacity < instances.size()) capacity *= 2;
+	// orphan the old storage so the GPU can keep reading it while we write
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+	instanceVbo->Unbind();
+	dirty = false;
+}
+
+void InstanceBatch::Draw(Shader& shader, size_t lod) {
+	drawCalls = 0;
+	if (instances.empty() || !model.isLoaded()) return;
+	if (!instanceVbo) setup();
+	if (dirty) upload();
+
+	// scene.vert takes the transform from the instance attributes
+	shader.setBool("instanced", true);
+	std::shared_ptr<ModelAsset> asset = model.getAsset();
+	for (size_t i = 0; i < asset->meshes.size() && i < vaos.size(); i++) {
+		// "model" holds only the mesh's own transform here
+		shader.setModelMatrix(asset->meshes[i]->getModelMatrix());
+		asset->meshes[i]->DrawInstanced(shader, *vaos[i], (GLsizei)instances.size(), lod);
+		drawCalls++;
+	}
+	shader.setBool("instanced", false);
+}
+
+void InstanceBatch::Delete() {
+	vaos.clear();
+	instanceVbo.reset();
+	capacity = 0;
+	dirty = true;
+}
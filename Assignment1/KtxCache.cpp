@@ -0,0 +1,163 @@
+#include "KtxCache.h"
+#include "FileUtils.h"
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+const char* KtxCache::DIRECTORY = "Cache/textures";
+
+namespace {
+	const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+	const uint32_t KTX_ENDIANNESS = 0x04030201;
+	// key of the key/value entry holding the source hash
+	const char HASH_KEY[] = "rtr.sourceHash";
+
+	struct KtxHeader {
+		unsigned char identifier[12];
+		uint32_t endianness;
+		uint32_t glType;
+		uint32_t glTypeSize;
+		uint32_t glFormat;
+		uint32_t glInternalFormat;
+		uint32_t glBaseInternalFormat;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t numberOfArrayElements;
+		uint32_t numberOfFaces;
+		uint32_t numberOfMipmapLevels;
+		uint32_t bytesOfKeyValueData;
+	};
+	static_assert(sizeof(KtxHeader) == 64, "KTX header must be 64 bytes");
+
+	size_t pad4(size_t n) { return (n + 3) & ~size_t(3); }
+
+	void append(std::vector<unsigned char>& out, const void* data, size_t size) {
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		out.insert(out.end(), p, p + size);
+	}
+}
+
+std::string KtxCache::cachePath(uint64_t sourceHash, BCFormat format) {
+	char name[64];
+	std::snprintf(name, sizeof(name), "%016llx_bc%u.ktx",
+		static_cast<unsigned long long>(sourceHash), static_cast<unsigned>(format));
+	return std::string(DIRECTORY) + "/" + name;
+}
+
+std::vector<unsigned char> KtxCache::Write(uint64_t sourceHash, const CompressedImage& image) {
+	// key/value entry: keyAndValueByteSize, "key\0", value, padding to 4 bytes
+	uint32_t kvSize = static_cast<uint32_t>(sizeof(HASH_KEY) + sizeof(uint64_t));
+	uint32_t kvBytes = static_cast<uint32_t>(sizeof(uint32_t) + pad4(kvSize));
+
+	KtxHeader header = {};
+	std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+	header.endianness = KTX_ENDIANNESS;
+	// compressed: no type / format, only the internal format
+	header.glType = 0;
+	header.glTypeSize = 1;
+	header.glFormat = 0;
+	header.glInternalFormat = TextureCompressor::InternalFormat(image.format);
+	header.glBaseInternalFormat = TextureCompressor::BaseFormat(image.format);
+	header.pixelWidth = static_cast<uint32_t>(image.width);
+	header.pixelHeight = static_cast<uint32_t>(image.height);
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = static_cast<uint32_t>(image.levels.size());
+	header.bytesOfKeyValueData = kvBytes;
+
+	std::vector<unsigned char> out;
+	append(out, &header, sizeof(header));
+	append(out, &kvSize, sizeof(kvSize));
+	append(out, HASH_KEY, sizeof(HASH_KEY));
+	append(out, &sourceHash, sizeof(sourceHash));
+	out.resize(sizeof(header) + kvBytes, 0);
+
+	// block sizes are multiples of 4, so no mip padding is needed
+	for (const std::vector<unsigned char>& level : image.levels) {
+		uint32_t imageSize = static_cast<uint32_t>(level.size());
+		append(out, &imageSize, sizeof(imageSize));
+		append(out, level.data(), level.size());
+	}
+	return out;
+}
+
+bool KtxCache::Read(const unsigned char* data, size_t size, uint64_t sourceHash, CompressedImage& out) {
+	if (size < sizeof(KtxHeader)) return false;
+	KtxHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	// only files we wrote ourselves: same endianness, 2D, one face, no arrays
+	if (std::memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) return false;
+	if (header.endianness != KTX_ENDIANNESS) return false;
+	if (header.glType != 0 || header.pixelDepth != 0 || header.numberOfArrayElements != 0
+		|| header.numberOfFaces != 1 || header.numberOfMipmapLevels == 0) return false;
+
+	const BCFormat formats[] = { BCFormat::BC1, BCFormat::BC4, BCFormat::BC5, BCFormat::BC7 };
+	bool known = false;
+	for (BCFormat f : formats) {
+		if (TextureCompressor::InternalFormat(f) == header.glInternalFormat) {
+			out.format = f;
+			known = true;
+		}
+	}
+	if (!known) return false;
+
+	// look for our hash in the key/value data
+	size_t pos = sizeof(KtxHeader);
+	size_t kvEnd = pos + header.bytesOfKeyValueData;
+	if (kvEnd > size) return false;
+	bool fresh = false;
+	while (pos + sizeof(uint32_t) <= kvEnd) {
+		uint32_t kvSize;
+		std::memcpy(&kvSize, data + pos, sizeof(kvSize));
+		pos += sizeof(kvSize);
+		if (pos + kvSize > kvEnd) return false;
+		if (kvSize == sizeof(HASH_KEY) + sizeof(uint64_t)
+			&& std::memcmp(data + pos, HASH_KEY, sizeof(HASH_KEY)) == 0) {
+			uint64_t stored;
+			std::memcpy(&stored, data + pos + sizeof(HASH_KEY), sizeof(stored));
+			fresh = stored == sourceHash;
+		}
+		pos += pad4(kvSize);
+	}
+	if (!fresh) return false;
+
+	out.width = static_cast<int>(header.pixelWidth);
+	out.height = static_cast<int>(header.pixelHeight);
+	out.levels.clear();
+	pos = kvEnd;
+	int w = out.width, h = out.height;
+	for (uint32_t level = 0; level < header.numberOfMipmapLevels; level++) {
+		if (pos + sizeof(uint32_t) > size) return false;
+		uint32_t imageSize;
+		std::memcpy(&imageSize, data + pos, sizeof(imageSize));
+		pos += sizeof(imageSize);
+		if (imageSize != TextureCompressor::LevelSize(out.format, w, h) || pos + imageSize > size) return false;
+		out.levels.emplace_back(data + pos, data + pos + imageSize);
+		pos += pad4(imageSize);
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	return true;
+}
+
+bool KtxCache::Load(uint64_t sourceHash, BCFormat format, CompressedImage& out) {
+	MappedFile file;
+	if (!file.Open(cachePath(sourceHash, format))) return false;
+	if (!Read(file.data(), file.size(), sourceHash, out) || out.format != format) {
+		std::cerr << "[KtxCache] Ignoring unreadable " << cachePath(sourceHash, format) << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool KtxCache::Save(uint64_t sourceHash, const CompressedImage& image) {
+	// Cache/ first, then Cache/textures/
+	ensureDirectory("Cache");
+	ensureDirectory(DIRECTORY);
+	std::vector<unsigned char> bytes = Write(sourceHash, image);
+	if (!writeFileAtomic(cachePath(sourceHash, image.format), bytes.data(), bytes.size())) {
+		std::cerr << "[KtxCache] Failed to write " << cachePath(sourceHash, image.format) << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -1,28 +1,92 @@
 #include "Mesh.h"
 #include "Shader.h"
+#include "VertexPacker.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
+#include <cstddef>
+#include <algorithm>
 
 // Constructor that generates a Mesh, need to initialze vbo and ebo
 Mesh::Mesh(const std::vector <Vertex>& vert, 
 			const std::vector <GLuint>& inds, 
 			const std::vector<std::shared_ptr<Texture>>& texs)
-	: vertices(vert), indices(inds), textures(texs), vbo(vertices), ebo(indices) {
+	: vertices(vert), indices(inds), textures(texs), indexCount((GLsizei)inds.size()), vertexCount(vert.size()),
+	  vbo(vertices), ebo(indices) {
+	lods.push_back({ 0, (uint32_t)indexCount, 0.0f });
+	// bounds for culling
+	if (!vertices.empty()) aabbMin = aabbMax = vertices[0].position;
+	for (const Vertex& v : vertices) {
+		aabbMin = glm::min(aabbMin, v.position);
+		aabbMax = glm::max(aabbMax, v.position);
+	}
+	setupVAO();
+}
+
+// Constructor that uploads a MeshView (importer output or mapped bake) directly
+Mesh::Mesh(const MeshView& view, const std::vector<std::shared_ptr<Texture>>& texs)
+	: textures(texs), indexCount((GLsizei)view.indexCount), vertexCount(view.vertexCount),
+	  aabbMin(view.aabbMin), aabbMax(view.aabbMax), format(view.format),
+	  vbo(static_cast<const void*>(nullptr), bufferSize(view)), ebo(view.indices, view.indexCount) {
+	if (view.lodCount > 0) lods.assign(view.lods, view.lods + view.lodCount);
+	else lods.push_back({ 0, (uint32_t)indexCount, 0.0f });
+	if (view.meshletCount > 0) clusters = ClusterCuller(view.meshlets, view.meshletCount);
+	if (format == VertexFormat::Packed) {
+		// colors (if any) follow the vertices in the same buffer
+		size_t vertexBytes = view.vertexCount * sizeof(PackedVertex);
+		vbo.Update(0, view.packedVertices, vertexBytes);
+		hasColor = view.colors != nullptr;
+		if (hasColor) vbo.Update(vertexBytes, view.colors, view.vertexCount * sizeof(uint32_t));
+		posScale = VertexPacker::PositionScale(aabbMin, aabbMax);
+		posOffset = VertexPacker::PositionOffset(aabbMin);
+		setupVAO();
+	}
+	else {
+		vbo.Update(0, view.vertices, view.vertexCount * sizeof(Vertex));
+		setupVAO();
+	}
+}
+
+size_t Mesh::bufferSize(const MeshView& view) {
+	if (view.format == VertexFormat::Float) return view.vertexCount * sizeof(Vertex);
+	return view.vertexCount * (sizeof(PackedVertex) + (view.colors ? sizeof(uint32_t) : 0));
+}
+
+void Mesh::setupVAO() {
+	LinkVertexLayout(vao);
+	// unbind to prevent accidental modification
+	vao.Unbind(); vbo.Unbind(); ebo.Unbind();
+}
+
+void Mesh::LinkVertexLayout(VAO& target) {
 	// bind vao since default constructor is already called
-	vao.Bind();
+	target.Bind();
 	ebo.Bind(); // sync with vao
+	LinkAttributes(target, vbo, format, hasColor ? &vbo : nullptr, vertexCount * sizeof(PackedVertex));
+}
+
+void Mesh::LinkAttributes(VAO& target, VBO& vertices, VertexFormat format, VBO* colors, size_t colorOffset) {
+	if (format == VertexFormat::Packed) {
+		GLsizei stride = sizeof(PackedVertex);
+		// positions (3 normalized ushorts, dequantized against the AABB in the shader)
+		target.LinkVBO(vertices, 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+		// octahedral normals (2 normalized shorts, decoded in the shader)
+		target.LinkVBO(vertices, 1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+		// vertex colors (4 normalized bytes from the color stream), white if the source had none
+		if (colors)
+			target.LinkVBO(*colors, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), (void*)colorOffset);
+		// texture coordinates (2 half floats)
+		target.LinkVBO(vertices, 3, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texUV));
+		return;
+	}
 
 	// link vertex positions (3 floats)
-	vao.LinkVBO(vbo, 0, 3, sizeof(Vertex), (void*)0);
+	target.LinkVBO(vertices, 0, 3, sizeof(Vertex), (void*)0);
 	// link normals (3 floats, start after first 3)
-	vao.LinkVBO(vbo, 1, 3, sizeof(Vertex), (void*)(3 * sizeof(float)));
+	target.LinkVBO(vertices, 1, 3, sizeof(Vertex), (void*)(3 * sizeof(float)));
 	// link vertex colors (3 floats, start after first 6)
-	vao.LinkVBO(vbo, 2, 3, sizeof(Vertex), (void*)(6 * sizeof(float)));
+	target.LinkVBO(vertices, 2, 3, sizeof(Vertex), (void*)(6 * sizeof(float)));
 	// link texture coordinates (2 floats, start after first 9)
-	vao.LinkVBO(vbo, 3, 2, sizeof(Vertex), (void*)(9 * sizeof(float)));
-
-	// unbind to prevent accidental modification
-	vao.Unbind(); vbo.Unbind(); ebo.Unbind();
+	target.LinkVBO(vertices, 3, 2, sizeof(Vertex), (void*)(9 * sizeof(float)));
 }
 
 void Mesh::setModelMatrix(const glm::mat4& m) {
@@ -49,7 +113,14 @@ void Mesh::setScale(const glm::vec3& scale) {
 	modelMatrix = glm::scale(modelMatrix, scale);
 }
 
-void Mesh::Draw(Shader& shader) {
+size_t Mesh::SelectLod(float pixelsPerUnit, float maxPixelError) const {
+	// errors grow with every level, stop at the first one that would be visible
+	size_t lod = 0;
+	while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError) lod++;
+	return lod;
+}
+
+void Mesh::BindMaterial(Shader& shader) {
 	// Keep track of how many of each type of textures we have
 	unsigned int numDiffuse = 0;
 	unsigned int numSpecular = 0;
@@ -68,9 +139,47 @@ void Mesh::Draw(Shader& shader) {
 		textures[i]->Bind();
 	}
 
-	// Draw the actual mesh
+	// tell scene.vert how to decode this mesh's vertices
+	bool packed = format == VertexFormat::Packed;
+	shader.setVec3("posScale", posScale);
+	shader.setVec3("posOffset", posOffset);
+	shader.setBool("octNormals", packed);
+	// a disabled attribute reads the current generic value instead
+	if (!hasColor) glVertexAttrib4f(2, 1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void Mesh::bindForDraw(Shader& shader) {
+	BindMaterial(shader);
+	// stays bound after the draw, the next mesh's bind replaces it (or is skipped)
 	vao.Bind();
-	glDrawElements(drawMode, indices.size(), GL_UNSIGNED_INT, 0);
-	vao.Unbind();
+}
 
-}
\ No newline at end of file
+void Mesh::Draw(Shader& shader, size_t lod) {
+	bindForDraw(shader);
+	// Draw the actual mesh
+	const MeshLod& range = lods[std::min(lod, lods.size() - 1)];
+	glDrawElements(drawMode, range.indexCount, GL_UNSIGNED_INT, (void*)(range.firstIndex * sizeof(GLuint)));
+}
+
+void Mesh::DrawClusters(Shader& shader, const Frustum& frustum, const glm::vec3& cameraPos) {
+	if (clusters.empty()) {
+		Draw(shader);
+		return;
+	}
+	clusters.Cull(frustum, cameraPos, drawCounts, drawOffsets);
+	if (drawCounts.empty()) return; // nothing visible
+
+	bindForDraw(shader);
+	// one call for all surviving (merged) index ranges
+	glMultiDrawElements(drawMode, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(), (GLsizei)drawCounts.size());
+}
+
+void Mesh::DrawInstanced(Shader& shader, VAO& instanceVao, GLsizei instanceCount, size_t lod) {
+	if (instanceCount <= 0) return;
+	BindMaterial(shader);
+	// same index range as Draw, repeated for every instance
+	instanceVao.Bind();
+	const MeshLod& range = lods[std::min(lod, lods.size() - 1)];
+	glDrawElementsInstanced(drawMode, range.indexCount, GL_UNSIGNED_INT,
+		(void*)(range.firstIndex * sizeof(GLuint)), instanceCount);
+}
@@ -0,0 +1,261 @@
+#include "MeshCache.h"
+#include <iostream>
+#include <cstring>
+
+const char* MeshCache::DIRECTORY = "Cache";
+
+// -------------------- File layout --------------------
+// [FileHeader][MeshRecord x meshCount][BlobRecord x textureCount][payload...]
+// All offsets are from the start of the file, payload blocks are 16-byte aligned.
+
+namespace {
+
+const char MAGIC[4] = { 'R', 'T', 'R', 'M' };
+
+struct FileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;   // content hash of the source model file
+	uint64_t optionsHash;  // texture overrides, skip list, ...
+	uint32_t importFlags;  // Assimp post-process flags
+	uint32_t vertexStride; // sizeof(Vertex) when baked
+	uint32_t packedStride; // sizeof(PackedVertex) when baked
+	uint32_t meshCount;
+	uint32_t textureCount;
+	float aabbMin[3];
+	float aabbMax[3];
+};
+
+struct TextureRecord {
+	uint32_t source;
+	int32_t embeddedIndex;
+	uint64_t pathOffset;
+	uint32_t pathLength;
+	uint32_t padding;
+};
+
+struct MeshRecord {
+	uint64_t vertexOffset;  // Vertex or PackedVertex array, depending on vertexFormat
+	uint64_t indexOffset;
+	uint64_t colorOffset;   // packed only: RGBA8 stream, 0 if none
+	uint64_t lodOffset;     // MeshLod array
+	uint64_t meshletOffset; // Meshlet array
+	uint32_t vertexCount;
+	uint32_t indexCount;    // all LODs together
+	uint32_t vertexFormat;
+	uint32_t lodCount;
+	uint32_t meshletCount;
+	uint32_t padding;
+	float aabbMin[3];
+	float aabbMax[3];
+	TextureRecord diffuse;
+	TextureRecord specular;
+};
+
+struct BlobRecord {
+	uint64_t offset;
+	uint64_t size;
+};
+
+// Appends a block to the payload and returns its offset
+uint64_t appendBlock(std::vector<unsigned char>& out, const void* data, size_t size) {
+	// keep every block aligned so the mapped data can be read in place
+	while (out.size() % 16 != 0) out.push_back(0);
+	uint64_t offset = out.size();
+	if (size > 0) {
+		out.insert(out.end(), static_cast<const unsigned char*>(data),
+			static_cast<const unsigned char*>(data) + size);
+	}
+	return offset;
+}
+
+void writeVec3(float* dst, const glm::vec3& v) {
+	dst[0] = v.x; dst[1] = v.y; dst[2] = v.z;
+}
+
+glm::vec3 readVec3(const float* src) {
+	return glm::vec3(src[0], src[1], src[2]);
+}
+
+TextureRecord writeTexture(std::vector<unsigned char>& out, const TextureRef& ref) {
+	TextureRecord rec = {};
+	rec.source = static_cast<uint32_t>(ref.source);
+	rec.embeddedIndex = ref.embeddedIndex;
+	rec.pathLength = static_cast<uint32_t>(ref.path.size());
+	rec.pathOffset = appendBlock(out, ref.path.data(), ref.path.size());
+	return rec;
+}
+
+bool readTexture(const unsigned char* base, size_t size, const TextureRecord& rec, TextureRef& ref) {
+	if (rec.pathOffset + rec.pathLength > size) return false;
+	ref.source = static_cast<TextureRef::Source>(rec.source);
+	ref.embeddedIndex = rec.embeddedIndex;
+	ref.path.assign(reinterpret_cast<const char*>(base + rec.pathOffset), rec.pathLength);
+	return true;
+}
+
+} // namespace
+
+std::string MeshCache::bakedPath(const std::string& sourcePath, uint64_t optionsHash) {
+	return std::string(DIRECTORY) + "/" + cacheFileName(sourcePath) + "_"
+		+ std::to_string(optionsHash) + ".rtrmesh";
+}
+
+bool MeshCache::Load(const std::string& sourcePath, uint32_t importFlags, uint64_t optionsHash) {
+	uint64_t sourceHash;
+	if (!hashFile(sourcePath, sourceHash)) return false;
+	if (!file.Open(bakedPath(sourcePath, optionsHash))) return false;
+
+	const unsigned char* base = file.data();
+	size_t size = file.size();
+
+	// validate header before trusting any offsets
+	FileHeader header;
+	if (size < sizeof(FileHeader)) return false;
+	std::memcpy(&header, base, sizeof(FileHeader));
+	if (std::memcmp(header.magic, MAGIC, 4) != 0 ||
+		header.version != VERSION ||
+		header.vertexStride != sizeof(Vertex) ||
+		header.packedStride != sizeof(PackedVertex) ||
+		header.sourceHash != sourceHash ||
+		header.importFlags != importFlags ||
+		header.optionsHash != optionsHash) {
+		std::cout << "[MeshCache] Stale bake for " << sourcePath << ", re-importing\n";
+		file.Close();
+		return false;
+	}
+
+	size_t tablesEnd = sizeof(FileHeader) + header.meshCount * sizeof(MeshRecord)
+		+ header.textureCount * sizeof(BlobRecord);
+	if (size < tablesEnd) { file.Close(); return false; }
+
+	const MeshRecord* meshes = reinterpret_cast<const MeshRecord*>(base + sizeof(FileHeader));
+	const BlobRecord* blobs = reinterpret_cast<const BlobRecord*>(meshes + header.meshCount);
+
+	modelView = ModelView();
+	modelView.aabbMin = readVec3(header.aabbMin);
+	modelView.aabbMax = readVec3(header.aabbMax);
+
+	for (uint32_t i = 0; i < header.meshCount; ++i) {
+		const MeshRecord& rec = meshes[i];
+		VertexFormat format = static_cast<VertexFormat>(rec.vertexFormat);
+		size_t stride = format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+		if (rec.vertexOffset + rec.vertexCount * stride > size ||
+			rec.indexOffset + rec.indexCount * sizeof(GLuint) > size ||
+			rec.colorOffset + (rec.colorOffset ? rec.vertexCount * sizeof(uint32_t) : 0) > size ||
+			rec.lodOffset + rec.lodCount * sizeof(MeshLod) > size ||
+			rec.meshletOffset + rec.meshletCount * sizeof(Meshlet) > size) {
+			file.Close();
+			return false;
+		}
+		// LOD ranges index into this mesh's index list
+		const MeshLod* lods = reinterpret_cast<const MeshLod*>(base + rec.lodOffset);
+		for (uint32_t l = 0; l < rec.lodCount; ++l) {
+			if (uint64_t(lods[l].firstIndex) + lods[l].indexCount > rec.indexCount) {
+				file.Close();
+				return false;
+			}
+		}
+		MeshView mv;
+		// point straight into the mapping, no copies
+		mv.format = format;
+		if (format == VertexFormat::Packed) {
+			mv.packedVertices = reinterpret_cast<const PackedVertex*>(base + rec.vertexOffset);
+			if (rec.colorOffset) mv.colors = reinterpret_cast<const uint32_t*>(base + rec.colorOffset);
+		}
+		else {
+			mv.vertices = reinterpret_cast<const Vertex*>(base + rec.vertexOffset);
+		}
+		mv.vertexCount = rec.vertexCount;
+		mv.indices = reinterpret_cast<const GLuint*>(base + rec.indexOffset);
+		mv.indexCount = rec.indexCount;
+		mv.lods = rec.lodCount ? reinterpret_cast<const MeshLod*>(base + rec.lodOffset) : nullptr;
+		mv.lodCount = rec.lodCount;
+		mv.meshlets = rec.meshletCount ? reinterpret_cast<const Meshlet*>(base + rec.meshletOffset) : nullptr;
+		mv.meshletCount = rec.meshletCount;
+		mv.aabbMin = readVec3(rec.aabbMin);
+		mv.aabbMax = readVec3(rec.aabbMax);
+		if (!readTexture(base, size, rec.diffuse, mv.diffuse) ||
+			!readTexture(base, size, rec.specular, mv.specular)) {
+			file.Close();
+			return false;
+		}
+		modelView.meshes.push_back(mv);
+	}
+
+	for (uint32_t i = 0; i < header.textureCount; ++i) {
+		if (blobs[i].offset + blobs[i].size > size) { file.Close(); return false; }
+		modelView.embeddedTextures.push_back({ base + blobs[i].offset, static_cast<size_t>(blobs[i].size) });
+	}
+	return true;
+}
+
+bool MeshCache::Save(const std::string& sourcePath, uint32_t importFlags, uint64_t optionsHash,
+	const ModelData& data) {
+	FileHeader header = {};
+	std::memcpy(header.magic, MAGIC, 4);
+	header.version = VERSION;
+	if (!hashFile(sourcePath, header.sourceHash)) return false;
+	header.optionsHash = optionsHash;
+	header.importFlags = importFlags;
+	header.vertexStride = sizeof(Vertex);
+	header.packedStride = sizeof(PackedVertex);
+	header.meshCount = static_cast<uint32_t>(data.meshes.size());
+	header.textureCount = static_cast<uint32_t>(data.embeddedTextures.size());
+	writeVec3(header.aabbMin, data.aabbMin);
+	writeVec3(header.aabbMax, data.aabbMax);
+
+	// reserve the tables up front, payload follows
+	size_t tablesSize = sizeof(FileHeader) + header.meshCount * sizeof(MeshRecord)
+		+ header.textureCount * sizeof(BlobRecord);
+	std::vector<unsigned char> out(tablesSize, 0);
+	std::vector<MeshRecord> meshes(header.meshCount);
+	std::vector<BlobRecord> blobs(header.textureCount);
+
+	for (size_t i = 0; i < data.meshes.size(); ++i) {
+		const MeshData& m = data.meshes[i];
+		MeshRecord& rec = meshes[i];
+		rec.vertexFormat = static_cast<uint32_t>(m.format);
+		rec.indexCount = static_cast<uint32_t>(m.indices.size());
+		if (m.format == VertexFormat::Packed) {
+			rec.vertexCount = static_cast<uint32_t>(m.packedVertices.size());
+			rec.vertexOffset = appendBlock(out, m.packedVertices.data(), m.packedVertices.size() * sizeof(PackedVertex));
+			if (!m.colors.empty())
+				rec.colorOffset = appendBlock(out, m.colors.data(), m.colors.size() * sizeof(uint32_t));
+		}
+		else {
+			rec.vertexCount = static_cast<uint32_t>(m.vertices.size());
+			rec.vertexOffset = appendBlock(out, m.vertices.data(), m.vertices.size() * sizeof(Vertex));
+		}
+		rec.indexOffset = appendBlock(out, m.indices.data(), m.indices.size() * sizeof(GLuint));
+		rec.lodCount = static_cast<uint32_t>(m.lods.size());
+		rec.lodOffset = appendBlock(out, m.lods.data(), m.lods.size() * sizeof(MeshLod));
+		rec.meshletCount = static_cast<uint32_t>(m.meshlets.size());
+		rec.meshletOffset = appendBlock(out, m.meshlets.data(), m.meshlets.size() * sizeof(Meshlet));
+		writeVec3(rec.aabbMin, m.aabbMin);
+		writeVec3(rec.aabbMax, m.aabbMax);
+		rec.diffuse = writeTexture(out, m.diffuse);
+		rec.specular = writeTexture(out, m.specular);
+	}
+	for (size_t i = 0; i < data.embeddedTextures.size(); ++i) {
+		const auto& bytes = data.embeddedTextures[i];
+		blobs[i].size = bytes.size();
+		blobs[i].offset = appendBlock(out, bytes.data(), bytes.size());
+	}
+
+	// fill in the tables now that offsets are known
+	std::memcpy(out.data(), &header, sizeof(FileHeader));
+	std::memcpy(out.data() + sizeof(FileHeader), meshes.data(), meshes.size() * sizeof(MeshRecord));
+	std::memcpy(out.data() + sizeof(FileHeader) + meshes.size() * sizeof(MeshRecord),
+		blobs.data(), blobs.size() * sizeof(BlobRecord));
+
+	ensureDirectory(DIRECTORY);
+	std::string path = bakedPath(sourcePath, optionsHash);
+	if (!writeFileAtomic(path, out.data(), out.size())) {
+		std::cerr << "[MeshCache] Failed to write " << path << std::endl;
+		return false;
+	}
+	std::cout << "[MeshCache] Baked " << sourcePath << " -> " << path
+		<< " (" << out.size() / 1024 << " KB)\n";
+	return true;
+}
@@ -0,0 +1,200 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <glm/glm.hpp>
+
+MeshOptimizer::Stats MeshOptimizer::Analyze(const GLuint* indices, size_t indexCount, size_t vertexCount,
+	unsigned int cacheSize) {
+	Stats stats;
+	if (indexCount < 3 || vertexCount == 0) return stats;
+
+	// a vertex is in the FIFO if it entered less than cacheSize misses ago
+	std::vector<size_t> enteredAt(vertexCount, 0);
+	size_t misses = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		GLuint v = indices[i];
+		if (enteredAt[v] == 0 || misses - enteredAt[v] >= cacheSize) {
+			misses++;
+			enteredAt[v] = misses;
+		}
+	}
+	stats.acmr = float(misses) / float(indexCount / 3);
+	stats.atvr = float(misses) / float(vertexCount);
+	return stats;
+}
+
+void MeshOptimizer::Optimize(MeshData& mesh, Stats& before, Stats& after) {
+	before = Analyze(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+	if (mesh.indices.size() < 3) {
+		after = before;
+		return;
+	}
+	std::vector<size_t> clusters = Tipsify(mesh.indices, mesh.vertices.size());
+	OptimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+	OptimizeVertexFetch(mesh.vertices, mesh.indices);
+	after = Analyze(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+}
+
+// -------------------- Tipsify --------------------
+
+std::vector<size_t> MeshOptimizer::Tipsify(std::vector<GLuint>& indices, size_t vertexCount,
+	unsigned int cacheSize) {
+	size_t triangleCount = indices.size() / 3;
+	std::vector<size_t> clusters;
+
+	// vertex -> triangles adjacency (CSR layout)
+	std::vector<unsigned int> live(vertexCount, 0);
+	for (GLuint v : indices) live[v]++;
+	std::vector<size_t> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + live[v];
+	std::vector<size_t> adjacency(indices.size());
+	{
+		std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; ++t)
+			for (int c = 0; c < 3; ++c)
+				adjacency[fill[indices[t * 3 + c]]++] = t;
+	}
+
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<GLuint> deadEnd;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+	// time starts past the cache size so untouched vertices count as misses
+	size_t time = cacheSize + 1;
+	size_t cursor = 0;
+	long long fanning = 0;
+
+	// next vertex with live triangles when the local neighbourhood is exhausted
+	auto skipDeadEnd = [&]() -> long long {
+		while (!deadEnd.empty()) {
+			GLuint d = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[d] > 0) return d;
+		}
+		while (cursor < vertexCount) {
+			if (live[cursor] > 0) return (long long)cursor++;
+			cursor++;
+		}
+		return -1;
+	};
+
+	clusters.push_back(0);
+	while (fanning >= 0) {
+		candidates.clear();
+		// emit every remaining triangle around the fanning vertex
+		for (size_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+			size_t t = adjacency[a];
+			if (emitted[t]) continue;
+			emitted[t] = true;
+			for (int c = 0; c < 3; ++c) {
+				GLuint v = indices[t * 3 + c];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				// miss: vertex enters the cache
+				if (time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+			}
+		}
+
+		// pick the candidate that will still be in the cache once its fan is emitted
+		long long best = -1;
+		long long bestPriority = -1;
+		for (GLuint v : candidates) {
+			if (live[v] == 0) continue;
+			long long priority = 0;
+			if (time - cacheTime[v] + 2 * live[v] <= cacheSize) priority = (long long)(time - cacheTime[v]);
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				best = v;
+			}
+		}
+		if (best < 0) {
+			best = skipDeadEnd();
+			// jumping elsewhere starts a new cluster for the overdraw pass
+			if (best >= 0 && output.size() / 3 > clusters.back()) clusters.push_back(output.size() / 3);
+		}
+		fanning = best;
+	}
+
+	indices.swap(output);
+	return clusters;
+}
+
+// -------------------- Overdraw --------------------
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+	const std::vector<size_t>& clusters, float threshold) {
+	size_t triangleCount = indices.size() / 3;
+	if (clusters.size() < 2) return;
+
+	// area weighted centroid of the whole mesh
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> clusterCentroid(clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormal(clusters.size(), glm::vec3(0.0f));
+	std::vector<float> clusterArea(clusters.size(), 0.0f);
+
+	for (size_t c = 0; c < clusters.size(); ++c) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		for (size_t t = clusters[c]; t < end; ++t) {
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(n) * 0.5f;
+			glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+			clusterCentroid[c] += centroid * area;
+			clusterNormal[c] += n; // length already weights by area
+			clusterArea[c] += area;
+		}
+		meshCentroid += clusterCentroid[c];
+		meshArea += clusterArea[c];
+	}
+	if (meshArea <= 0.0f) return;
+	meshCentroid /= meshArea;
+
+	// clusters facing away from the centre occlude the rest: draw them first
+	std::vector<float> sortKey(clusters.size(), 0.0f);
+	for (size_t c = 0; c < clusters.size(); ++c) {
+		if (clusterArea[c] <= 0.0f) continue;
+		glm::vec3 centroid = clusterCentroid[c] / clusterArea[c];
+		float len = glm::length(clusterNormal[c]);
+		if (len > 0.0f) sortKey[c] = glm::dot(centroid - meshCentroid, clusterNormal[c] / len);
+	}
+	std::vector<size_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+	std::vector<GLuint> sorted;
+	sorted.reserve(indices.size());
+	for (size_t c : order) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		sorted.insert(sorted.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+	}
+
+	// cluster seams cost some cache hits, don't trade away too much
+	Stats tipsify = Analyze(indices.data(), indices.size(), vertices.size());
+	Stats clustered = Analyze(sorted.data(), sorted.size(), vertices.size());
+	if (clustered.acmr <= tipsify.acmr * threshold) indices.swap(sorted);
+}
+
+// -------------------- Vertex fetch --------------------
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+	const GLuint unused = ~GLuint(0);
+	std::vector<GLuint> remap(vertices.size(), unused);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (GLuint& index : indices) {
+		if (remap[index] == unused) {
+			remap[index] = static_cast<GLuint>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices.swap(reordered);
+}
@@ -0,0 +1,290 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+// Symmetric 4x4 error quadric: Q(p) = p^T A p + 2 b.p + c, plus the total
+// weight of its planes so the error can be read as a squared distance
+struct Quadric {
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0 = 0, b1 = 0, b2 = 0;
+	double c = 0;
+	double weight = 0;
+
+	// squared distance to the plane n.p + d = 0, scaled by weight
+	static Quadric FromPlane(const glm::dvec3& n, double d, double weight) {
+		Quadric q;
+		q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z;
+		q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z; q.a22 = weight * n.z * n.z;
+		q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+		q.c = weight * d * d;
+		q.weight = weight;
+		return q;
+	}
+
+	Quadric& operator+=(const Quadric& o) {
+		a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+		b0 += o.b0; b1 += o.b1; b2 += o.b2; c += o.c;
+		weight += o.weight;
+		return *this;
+	}
+
+	double Evaluate(const glm::vec3& p) const {
+		double x = p.x, y = p.y, z = p.z;
+		double r = a00 * x * x + a11 * y * y + a22 * z * z
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		// rounding can push a perfect fit slightly negative
+		return r > 0.0 ? r : 0.0;
+	}
+
+	// weighted mean squared distance to the planes (mesh units squared), so
+	// the error doesn't depend on the mesh's scale or triangle density
+	double Error(const glm::vec3& p) const {
+		return weight > 0.0 ? Evaluate(p) / weight : 0.0;
+	}
+};
+
+enum VertexKind : unsigned char {
+	Manifold, // interior vertex, may collapse onto any neighbour
+	Border,   // on an open edge, may only collapse along that edge
+	Locked    // attribute seam, never moves
+};
+
+// border edges weigh more than surface planes so silhouettes hold longer
+const double BORDER_WEIGHT = 10.0;
+
+uint64_t edgeKey(GLuint a, GLuint b) {
+	return (uint64_t(a) << 32) | b;
+}
+
+struct Collapse {
+	GLuint from;
+	GLuint to;
+	double cost;
+};
+
+} // namespace
+
+std::vector<GLuint> MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices,
+	size_t targetIndexCount, float targetError, float& resultError) {
+	resultError = 0.0f;
+	std::vector<GLuint> result(indices);
+	size_t vertexCount = vertices.size();
+	if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+	// vertices sharing a position (seams after JoinIdenticalVertices) map to one canonical id
+	std::vector<GLuint> canonical(vertexCount);
+	std::vector<unsigned int> wedgeCount(vertexCount, 0);
+	{
+		struct PosHash {
+			size_t operator()(const glm::vec3& p) const {
+				uint32_t h[3];
+				std::memcpy(h, &p, sizeof(h));
+				return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+			}
+		};
+		std::unordered_map<glm::vec3, GLuint, PosHash> firstAt;
+		firstAt.reserve(vertexCount);
+		for (GLuint v = 0; v < vertexCount; ++v) {
+			auto it = firstAt.emplace(vertices[v].position, v).first;
+			canonical[v] = it->second;
+			wedgeCount[it->second]++;
+		}
+	}
+
+	// open edges: a directed canonical edge without its reverse
+	std::vector<uint64_t> edges;
+	auto rebuildEdges = [&]() {
+		edges.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int e = 0; e < 3; ++e) {
+				GLuint a = canonical[result[i + e]], b = canonical[result[i + (e + 1) % 3]];
+				edges.push_back(edgeKey(a, b));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+	};
+	rebuildEdges();
+	auto hasEdge = [&](GLuint a, GLuint b) {
+		return std::binary_search(edges.begin(), edges.end(), edgeKey(a, b));
+	};
+	auto isBorderEdge = [&](GLuint a, GLuint b) {
+		GLuint ca = canonical[a], cb = canonical[b];
+		return hasEdge(ca, cb) != hasEdge(cb, ca);
+	};
+
+	std::vector<unsigned char> kind(vertexCount, Manifold);
+	for (GLuint v = 0; v < vertexCount; ++v) {
+		if (wedgeCount[canonical[v]] > 1) kind[v] = Locked;
+	}
+
+	// plane quadrics of every triangle (area weighted) plus border planes
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < result.size(); i += 3) {
+		glm::dvec3 p[3];
+		for (int c = 0; c < 3; ++c) p[c] = glm::dvec3(vertices[result[i + c]].position);
+		glm::dvec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+		double len = glm::length(n);
+		if (len <= 0.0) continue;
+		n /= len;
+		Quadric q = Quadric::FromPlane(n, -glm::dot(n, p[0]), len * 0.5);
+		for (int c = 0; c < 3; ++c) quadrics[result[i + c]] += q;
+
+		for (int e = 0; e < 3; ++e) {
+			GLuint a = result[i + e], b = result[i + (e + 1) % 3];
+			if (!isBorderEdge(a, b)) continue;
+			if (kind[a] == Manifold) kind[a] = Border;
+			if (kind[b] == Manifold) kind[b] = Border;
+			// plane through the edge, perpendicular to the triangle
+			glm::dvec3 edge = p[(e + 1) % 3] - p[e];
+			double edgeLen = glm::length(edge);
+			if (edgeLen <= 0.0) continue;
+			glm::dvec3 bn = glm::normalize(glm::cross(edge, n));
+			Quadric bq = Quadric::FromPlane(bn, -glm::dot(bn, p[e]), edgeLen * edgeLen * BORDER_WEIGHT);
+			quadrics[a] += bq;
+			quadrics[b] += bq;
+		}
+	}
+
+	double errorLimit = double(targetError) * double(targetError);
+	double maxCost = 0.0;
+	std::vector<GLuint> remap(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<Collapse> candidates;
+	std::vector<size_t> adjOffsets, adjacency;
+
+	while (result.size() > targetIndexCount) {
+		size_t triangleCount = result.size() / 3;
+		// collapses create new border edges between border vertices
+		rebuildEdges();
+
+		// vertex -> triangles for the flip test
+		adjOffsets.assign(vertexCount + 1, 0);
+		for (GLuint v : result) adjOffsets[v + 1]++;
+		for (size_t v = 0; v < vertexCount; ++v) adjOffsets[v + 1] += adjOffsets[v];
+		adjacency.resize(result.size());
+		{
+			std::vector<size_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+			for (size_t t = 0; t < triangleCount; ++t)
+				for (int c = 0; c < 3; ++c) adjacency[fill[result[t * 3 + c]]++] = t;
+		}
+
+		auto canCollapse = [&](GLuint from, GLuint to) {
+			if (kind[from] == Locked) return false;
+			if (kind[from] == Border) return isBorderEdge(from, to);
+			return true;
+		};
+
+		// cheapest direction of every edge
+		candidates.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (int e = 0; e < 3; ++e) {
+				GLuint a = result[i + e], b = result[i + (e + 1) % 3];
+				Quadric q = quadrics[a];
+				q += quadrics[b];
+				double costAB = canCollapse(a, b) ? q.Error(vertices[b].position) : -1.0;
+				double costBA = canCollapse(b, a) ? q.Error(vertices[a].position) : -1.0;
+				if (costAB < 0.0 && costBA < 0.0) continue;
+				if (costBA < 0.0 || (costAB >= 0.0 && costAB <= costBA)) candidates.push_back({ a, b, costAB });
+				else candidates.push_back({ b, a, costBA });
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(),
+			[](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		for (GLuint v = 0; v < vertexCount; ++v) remap[v] = v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		// each collapse removes about two triangles
+		size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+		size_t removed = 0;
+		size_t collapses = 0;
+		for (const Collapse& c : candidates) {
+			if (removed >= trianglesToRemove || c.cost > errorLimit) break;
+			if (touched[c.from] || touched[c.to]) continue;
+
+			// reject collapses that flip (or nearly flip) a surrounding triangle
+			const glm::vec3& target = vertices[c.to].position;
+			bool flips = false;
+			size_t lost = 0;
+			for (size_t a = adjOffsets[c.from]; a < adjOffsets[c.from + 1] && !flips; ++a) {
+				const GLuint* tri = &result[adjacency[a] * 3];
+				if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+					lost++;
+					continue;
+				}
+				glm::vec3 p[3], q[3];
+				for (int k = 0; k < 3; ++k) {
+					p[k] = vertices[tri[k]].position;
+					q[k] = tri[k] == c.from ? target : p[k];
+				}
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+				if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) flips = true;
+			}
+			if (flips) continue;
+
+			// freeze the whole one-ring so the flip test stays valid this pass
+			for (size_t a = adjOffsets[c.from]; a < adjOffsets[c.from + 1]; ++a) {
+				const GLuint* tri = &result[adjacency[a] * 3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			}
+			remap[c.from] = c.to;
+			quadrics[c.to] += quadrics[c.from];
+			maxCost = std::max(maxCost, c.cost);
+			removed += lost;
+			collapses++;
+		}
+		if (collapses == 0) break;
+
+		// apply the collapses, dropping triangles that became degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			GLuint a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (a == b || b == c || a == c) continue;
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	resultError = float(std::sqrt(maxCost));
+	return result;
+}
+
+void MeshSimplifier::BuildLods(MeshData& mesh, size_t maxLods, float maxError) {
+	mesh.lods.clear();
+	MeshLod lod0;
+	lod0.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	mesh.lods.push_back(lod0);
+
+	float limit = maxError * glm::length(mesh.aabbMax - mesh.aabbMin);
+	float accumulated = 0.0f;
+	std::vector<GLuint> current(mesh.indices);
+
+	while (mesh.lods.size() < maxLods) {
+		size_t target = (current.size() / 2) / 3 * 3;
+		float error = 0.0f;
+		std::vector<GLuint> next = Simplify(mesh.vertices, current, target, limit - accumulated, error);
+		// stop once the error budget no longer allows a worthwhile reduction
+		if (next.empty() || next.size() > current.size() * 8 / 10) break;
+
+		MeshOptimizer::Tipsify(next, mesh.vertices.size());
+		// each level is built from the previous one, so errors add up
+		accumulated += error;
+
+		MeshLod lod;
+		lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+		lod.indexCount = static_cast<uint32_t>(next.size());
+		lod.error = accumulated;
+		mesh.lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+		current.swap(next);
+	}
+}
@@ -0,0 +1,264 @@
+#include "Meshlets.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RTR_SSE2 1
+#endif
+
+// -------------------- Builder --------------------
+
+namespace {
+
+void finishMeshlet(const MeshData& mesh, Meshlet& m) {
+	const GLuint* idx = mesh.indices.data() + m.firstIndex;
+
+	// bounding sphere around the cluster's AABB center
+	glm::vec3 lo(std::numeric_limits<float>::max()), hi(-std::numeric_limits<float>::max());
+	for (uint32_t i = 0; i < m.indexCount; ++i) {
+		lo = glm::min(lo, mesh.vertices[idx[i]].position);
+		hi = glm::max(hi, mesh.vertices[idx[i]].position);
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t i = 0; i < m.indexCount; ++i)
+		radius = std::max(radius, glm::length(mesh.vertices[idx[i]].position - center));
+
+	// normal cone: average facing and the widest deviation from it
+	std::vector<glm::vec3> normals;
+	normals.reserve(m.indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = 0; i < m.indexCount; i += 3) {
+		const glm::vec3& p0 = mesh.vertices[idx[i]].position;
+		glm::vec3 n = glm::cross(mesh.vertices[idx[i + 1]].position - p0, mesh.vertices[idx[i + 2]].position - p0);
+		float len = glm::length(n);
+		if (len <= 0.0f) continue;
+		normals.push_back(n / len);
+		axis += normals.back();
+	}
+	float cutoff = 2.0f;
+	float axisLen = glm::length(axis);
+	if (axisLen > 0.0f) {
+		axis /= axisLen;
+		float minDot = 1.0f;
+		for (const glm::vec3& n : normals) minDot = std::min(minDot, glm::dot(axis, n));
+		// cones wider than ~85 degrees almost never cull, don't bother
+		if (minDot > 0.1f) cutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+	else {
+		axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+
+	for (int c = 0; c < 3; ++c) {
+		m.center[c] = center[c];
+		m.coneAxis[c] = axis[c];
+	}
+	m.radius = radius;
+	m.coneCutoff = cutoff;
+}
+
+} // namespace
+
+void MeshletBuilder::Build(MeshData& mesh, size_t maxVertices, size_t maxTriangles) {
+	mesh.meshlets.clear();
+	size_t lod0Count = mesh.lods.empty() ? mesh.indices.size() : mesh.lods[0].indexCount;
+	if (lod0Count == 0) return;
+
+	// vertices already in the open meshlet
+	std::vector<uint32_t> usedBy(mesh.vertices.size(), UINT32_MAX);
+	Meshlet current;
+	size_t vertexCount = 0;
+	uint32_t meshletId = 0;
+
+	for (size_t i = 0; i + 2 < lod0Count; i += 3) {
+		size_t newVertices = 0;
+		for (int c = 0; c < 3; ++c)
+			if (usedBy[mesh.indices[i + c]] != meshletId) newVertices++;
+
+		// close the meshlet when this triangle doesn't fit anymore
+		if (vertexCount + newVertices > maxVertices || current.indexCount / 3 >= maxTriangles) {
+			finishMeshlet(mesh, current);
+			mesh.meshlets.push_back(current);
+			current = Meshlet();
+			current.firstIndex = static_cast<uint32_t>(i);
+			vertexCount = 0;
+			meshletId++;
+		}
+		for (int c = 0; c < 3; ++c) {
+			GLuint v = mesh.indices[i + c];
+			if (usedBy[v] != meshletId) {
+				usedBy[v] = meshletId;
+				vertexCount++;
+			}
+		}
+		current.indexCount += 3;
+	}
+	finishMeshlet(mesh, current);
+	mesh.meshlets.push_back(current);
+}
+
+// -------------------- Culler --------------------
+
+bool ClusterCuller::enabled = true;
+size_t ClusterCuller::tested = 0;
+size_t ClusterCuller::visible = 0;
+
+void ClusterCuller::ResetStats() {
+	tested = 0;
+	visible = 0;
+}
+
+ClusterCuller::ClusterCuller(const Meshlet* meshlets, size_t meshletCount)
+	: count(meshletCount) {
+	size_t padded = (count + 3) & ~size_t(3);
+	// padding: a hugely negative radius fails every plane test, so it is always culled
+	cx.assign(padded, 0.0f); cy.assign(padded, 0.0f); cz.assign(padded, 0.0f);
+	radius.assign(padded, -1e30f);
+	ax.assign(padded, 0.0f); ay.assign(padded, 0.0f); az.assign(padded, 1.0f);
+	cutoff.assign(padded, 2.0f);
+	firstIndex.assign(padded, 0);
+	indexCount.assign(padded, 0);
+	for (size_t i = 0; i < count; ++i) {
+		const Meshlet& m = meshlets[i];
+		cx[i] = m.center[0]; cy[i] = m.center[1]; cz[i] = m.center[2];
+		radius[i] = m.radius;
+		ax[i] = m.coneAxis[0]; ay[i] = m.coneAxis[1]; az[i] = m.coneAxis[2];
+		cutoff[i] = m.coneCutoff;
+		firstIndex[i] = m.firstIndex;
+		indexCount[i] = m.indexCount;
+	}
+}
+
+bool ClusterCuller::testScalar(size_t i, const Frustum& frustum, const glm::vec3& cameraPos) const {
+	glm::vec3 center(cx[i], cy[i], cz[i]);
+	if (!frustum.IntersectsSphere(center, radius[i])) return false;
+	// every triangle faces away if the view direction lies inside the (widened) cone
+	glm::vec3 toCluster = center - cameraPos;
+	float along = glm::dot(toCluster, glm::vec3(ax[i], ay[i], az[i]));
+	return along < cutoff[i] * glm::length(toCluster) + radius[i];
+}
+
+#ifdef RTR_SSE2
+unsigned int ClusterCuller::testSimd(size_t begin, const Frustum& frustum, const glm::vec3& cameraPos) const {
+	__m128 x = _mm_loadu_ps(&cx[begin]);
+	__m128 y = _mm_loadu_ps(&cy[begin]);
+	__m128 z = _mm_loadu_ps(&cz[begin]);
+	__m128 r = _mm_loadu_ps(&radius[begin]);
+	__m128 negR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+	// inside all six planes: n.c + d >= -r
+	__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (const glm::vec4& p : frustum.planes) {
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+			_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+	}
+
+	// cone: visible if dot(c - cam, axis) < cutoff * |c - cam| + r
+	__m128 dx = _mm_sub_ps(x, _mm_set1_ps(cameraPos.x));
+	__m128 dy = _mm_sub_ps(y, _mm_set1_ps(cameraPos.y));
+	__m128 dz = _mm_sub_ps(z, _mm_set1_ps(cameraPos.z));
+	__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+	__m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&ax[begin])), _mm_mul_ps(dy, _mm_loadu_ps(&ay[begin]))),
+		_mm_mul_ps(dz, _mm_loadu_ps(&az[begin])));
+	__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[begin]), len), r);
+	__m128 front = _mm_cmplt_ps(along, limit);
+
+	return static_cast<unsigned int>(_mm_movemask_ps(_mm_and_ps(inside, front)));
+}
+#else
+unsigned int ClusterCuller::testSimd(size_t begin, const Frustum& frustum, const glm::vec3& cameraPos) const {
+	unsigned int mask = 0;
+	for (size_t k = 0; k < 4; ++k)
+		if (testScalar(begin + k, frustum, cameraPos)) mask |= 1u << k;
+	return mask;
+}
+#endif
+
+void ClusterCuller::emit(size_t i, std::vector<GLsizei>& counts, std::vector<const void*>& offsets) const {
+	// extend the previous range if this cluster follows it directly
+	if (!counts.empty()) {
+		size_t prevEnd = reinterpret_cast<size_t>(offsets.back()) / sizeof(GLuint) + counts.back();
+		if (prevEnd == firstIndex[i]) {
+			counts.back() += indexCount[i];
+			return;
+		}
+	}
+	counts.push_back(static_cast<GLsizei>(indexCount[i]));
+	offsets.push_back(reinterpret_cast<const void*>(size_t(firstIndex[i]) * sizeof(GLuint)));
+}
+
+void ClusterCuller::Cull(const Frustum& frustum, const glm::vec3& cameraPos,
+	std::vector<GLsizei>& counts, std::vector<const void*>& offsets, bool simd) const {
+	counts.clear();
+	offsets.clear();
+	size_t drawn = 0;
+	if (simd) {
+		for (size_t begin = 0; begin < count; begin += 4) {
+			unsigned int mask = testSimd(begin, frustum, cameraPos);
+			for (size_t k = 0; mask; ++k, mask >>= 1) {
+				if (mask & 1u) {
+					emit(begin + k, counts, offsets);
+					drawn++;
+				}
+			}
+		}
+	}
+	else {
+		for (size_t i = 0; i < count; ++i) {
+			if (testScalar(i, frustum, cameraPos)) {
+				emit(i, counts, offsets);
+				drawn++;
+			}
+		}
+	}
+	tested += count;
+	visible += drawn;
+}
+
+// -------------------- Benchmark --------------------
+
+void ClusterCuller::Benchmark(size_t clusterCount, int iterations) {
+	// random small clusters scattered in a 100 unit cube, random facing
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> pos(-50.0f, 50.0f), dir(-1.0f, 1.0f), size(0.05f, 0.5f);
+	std::vector<Meshlet> meshlets(clusterCount);
+	for (size_t i = 0; i < clusterCount; ++i) {
+		Meshlet& m = meshlets[i];
+		m.firstIndex = static_cast<uint32_t>(i * 372);
+		m.indexCount = 372;
+		glm::vec3 axis = glm::normalize(glm::vec3(dir(rng), dir(rng), dir(rng)) + glm::vec3(1e-4f));
+		for (int c = 0; c < 3; ++c) {
+			m.center[c] = pos(rng);
+			m.coneAxis[c] = axis[c];
+		}
+		m.radius = size(rng);
+		m.coneCutoff = 0.5f;
+	}
+	ClusterCuller culler(meshlets.data(), meshlets.size());
+
+	glm::mat4 proj = glm::perspective(glm::radians(50.0f), 16.0f / 9.0f, 0.5f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::FromMatrix(proj * view);
+	glm::vec3 cameraPos(0.0f, 0.0f, 60.0f);
+
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	for (int mode = 0; mode < 2; ++mode) {
+		bool simd = mode == 0;
+		ResetStats();
+		auto start = std::chrono::steady_clock::now();
+		for (int it = 0; it < iterations; ++it) culler.Cull(frustum, cameraPos, counts, offsets, simd);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "[ClusterCuller] " << (simd ? "SIMD  " : "scalar") << ": " << clusterCount << " clusters in "
+			<< ms / iterations << " ms (" << clusterCount * iterations / (ms * 1000.0) << " M clusters/s), "
+			<< visible / iterations << " visible, " << counts.size() << " draw ranges\n";
+	}
+	ResetStats();
+}
@@ -0,0 +1,435 @@
+#include "ModelLoader.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "VertexPacker.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <assimp/texture.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+const unsigned int ModelLoader::IMPORT_FLAGS =
+    aiProcess_Triangulate           | // Ensures all faces are triangles
+    aiProcess_GenNormals            | // Generates normals if missing
+    aiProcess_JoinIdenticalVertices |  // Optimizes geometry
+    aiProcess_PreTransformVertices  | // Bake node transforms into vertices
+    aiProcess_OptimizeMeshes; // Merge tiny meshes to reduce draw calls
+
+// Everything one load carries between the CPU and the GL stage
+struct ModelLoader::LoadJob {
+    std::string path;
+    std::string key;
+    ModelOptions options;
+    std::shared_ptr<PendingModel> handle;
+
+    // CPU stage output: either a mapped bake or freshly imported data
+    bool ok = false;
+    MeshCache baked;
+    ModelData imported;
+    ModelView view;
+
+    // GL stage progress
+    std::shared_ptr<ModelAsset> asset = std::make_shared<ModelAsset>();
+    size_t nextMesh = 0;
+};
+
+std::string ModelOptions::cacheKey(const std::string& path, unsigned int flags) const {
+    std::string key = path + "|" + std::to_string(flags) + "|" + diffusePath + "|" + specularPath
+        + (optimizeMeshes ? "|opt" : "") + (generateLods ? "|lod" : "") + (buildMeshlets ? "|meshlets" : "") + (packVertices ? "|packed" : "|float");
+    for (const auto& s : skipNames) key += "|" + s;
+    return key;
+}
+
+ModelLoader& ModelLoader::Instance() {
+    static ModelLoader loader;
+    return loader;
+}
+
+// -------------------- Public API --------------------
+
+std::shared_ptr<ModelAsset> ModelLoader::Load(const std::string& path, const ModelOptions& options) {
+    // reuse the shared asset if this file was already loaded with the same options
+    std::string key = options.cacheKey(path, IMPORT_FLAGS);
+    if (std::shared_ptr<ModelAsset> cached = AssetCache::Instance().Find(key)) {
+        std::cout << "[Model] Reusing cached asset: " << path << std::endl;
+        return cached;
+    }
+
+    // run both stages back to back on this thread
+    LoadJob job;
+    job.path = path;
+    job.key = key;
+    job.options = options;
+    runCpuStage(job);
+    while (!uploadNext(job)) {}
+    finish(job);
+    // blocking load means the textures are there too
+    TextureStreamer::Instance().Flush();
+    return job.asset;
+}
+
+std::shared_ptr<PendingModel> ModelLoader::LoadAsync(const std::string& path, const ModelOptions& options) {
+    std::string key = options.cacheKey(path, IMPORT_FLAGS);
+
+    // already loaded: hand back a finished handle
+    if (std::shared_ptr<ModelAsset> cached = AssetCache::Instance().Find(key)) {
+        auto handle = std::make_shared<PendingModel>();
+        handle->sourcePath = path;
+        handle->asset = cached;
+        handle->state = PendingModel::Ready;
+        return handle;
+    }
+    // already loading: share the same job
+    auto it = inFlight.find(key);
+    if (it != inFlight.end()) return it->second;
+
+    auto job = std::make_shared<LoadJob>();
+    job->path = path;
+    job->key = key;
+    job->options = options;
+    job->handle = std::make_shared<PendingModel>();
+    job->handle->sourcePath = path;
+    inFlight[key] = job->handle;
+
+    ThreadPool::Shared().Submit([this, job]() {
+        runCpuStage(*job);
+        // hand over to the render thread
+        std::lock_guard<std::mutex> lock(readyMutex);
+        readyJobs.push_back(job);
+    });
+    return job->handle;
+}
+
+void ModelLoader::ProcessUploads(double budgetMs) {
+    using clock = std::chrono::steady_clock;
+    clock::time_point start = clock::now();
+    for (;;) {
+        std::shared_ptr<LoadJob> job;
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            if (readyJobs.empty()) return;
+            job = readyJobs.front();
+        }
+
+        // one mesh (VBO/EBO/VAO + its textures) per step
+        if (uploadNext(*job)) {
+            finish(*job);
+            std::lock_guard<std::mutex> lock(readyMutex);
+            readyJobs.pop_front();
+        }
+
+        double elapsedMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        if (elapsedMs >= budgetMs) return;
+    }
+}
+
+// -------------------- CPU stage --------------------
+
+void ModelLoader::runCpuStage(LoadJob& job) {
+    uint64_t optionsHash = hashString(job.key);
+
+    // warm start: map the baked file and upload it without touching Assimp
+    if (job.baked.Load(job.path, IMPORT_FLAGS, optionsHash)) {
+        std::cout << "[Model] Loaded baked mesh cache: " << job.path << std::endl;
+        job.view = job.baked.view();
+        job.ok = true;
+    }
+    else if (importModel(job)) {
+        // write the bake for the next launch
+        MeshCache::Save(job.path, IMPORT_FLAGS, optionsHash, job.imported);
+        job.view = job.imported.view();
+        job.ok = true;
+    }
+}
+
+std::string ModelLoader::textureKey(const TextureRef& ref, const std::string& modelPath, const char* typeName) {
+    if (ref.source == TextureRef::Source::Embedded)
+        return TextureCache::KeyForEmbedded(modelPath, ref.embeddedIndex, typeName);
+    if (ref.source == TextureRef::Source::File)
+        return TextureCache::KeyForFile(ref.path, typeName);
+    return "";
+}
+
+bool ModelLoader::importModel(LoadJob& job) {
+    // create Assimp importer
+    Assimp::Importer importer;
+
+    // import the 3D model file
+    const aiScene* scene = importer.ReadFile(job.path, IMPORT_FLAGS);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::cerr << "Error loading model: " << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    // begin recursively processing the model hierarchy
+    ModelData& data = job.imported;
+    processNode(scene->mRootNode, scene, job.options, data);
+
+    // reorder for the GPU while the vertices are still plain floats
+    if (job.options.optimizeMeshes) {
+        for (size_t i = 0; i < data.meshes.size(); ++i) {
+            MeshOptimizer::Stats before, after;
+            MeshOptimizer::Optimize(data.meshes[i], before, after);
+            std::cout << "[MeshOptimizer] Mesh " << i << ": ACMR " << before.acmr << " -> " << after.acmr
+                << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        }
+    }
+
+    // coarser index ranges appended to each mesh's index buffer
+    if (job.options.generateLods) {
+        for (size_t i = 0; i < data.meshes.size(); ++i) {
+            MeshData& m = data.meshes[i];
+            MeshSimplifier::BuildLods(m);
+            std::cout << "[MeshSimplifier] Mesh " << i << ": " << m.lods.size() << " LODs, triangles";
+            for (const MeshLod& lod : m.lods) std::cout << " " << lod.indexCount / 3;
+            std::cout << std::endl;
+        }
+    }
+
+    // clusters of the final LOD0 order (needs the float positions)
+    if (job.options.buildMeshlets) {
+        size_t meshletCount = 0;
+        for (MeshData& m : data.meshes) {
+            MeshletBuilder::Build(m);
+            meshletCount += m.meshlets.size();
+        }
+        std::cout << "[Model] Built " << meshletCount << " meshlets" << std::endl;
+    }
+
+    // final step: shrink the vertices for upload and the bake
+    if (job.options.packVertices) {
+        size_t floatBytes = 0, packedBytes = 0;
+        for (MeshData& m : data.meshes) {
+            floatBytes += m.vertices.size() * sizeof(Vertex);
+            VertexPacker::Pack(m);
+            packedBytes += m.packedVertices.size() * sizeof(PackedVertex) + m.colors.size() * sizeof(uint32_t);
+        }
+        std::cout << "[Model] Packed vertices: " << floatBytes / 1024 << " KB -> "
+            << packedBytes / 1024 << " KB\n";
+    }
+
+    // keep the compressed embedded images (GLB case) so the bake is self-contained
+    data.embeddedTextures.resize(scene->mNumTextures);
+    for (unsigned int i = 0; i < scene->mNumTextures; i++) {
+        const aiTexture* tex = scene->mTextures[i];
+        if (tex && tex->mHeight == 0) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(tex->pcData);
+            data.embeddedTextures[i].assign(bytes, bytes + tex->mWidth);
+        }
+    }
+    return true;
+}
+
+static bool shouldSkipMesh(const std::string& name, const ModelOptions& options) {
+    for (const auto& s : options.skipNames) {
+        if (name.find(s) != std::string::npos) return true;
+    }
+    return false;
+}
+
+void ModelLoader::processNode(aiNode* node, const aiScene* scene, const ModelOptions& options, ModelData& data) {
+    // process all the node's meshes (if any)
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+
+        // Debug: print mesh info
+        std::string meshName = mesh->mName.C_Str();
+        std::cout << "[Model] Mesh: " << meshName
+            << " | Vertices: " << mesh->mNumVertices << std::endl;
+
+        if (shouldSkipMesh(meshName, options)) {
+            std::cout << "[Model] Skipping mesh: " << meshName << std::endl;
+            continue;
+        }
+
+        // store mesh
+        data.meshes.emplace_back(processMesh(mesh, scene, options));
+
+        // expand model-space AABB
+        const MeshData& m = data.meshes.back();
+        data.aabbMin = glm::min(data.aabbMin, m.aabbMin);
+        data.aabbMax = glm::max(data.aabbMax, m.aabbMax);
+    }
+    // then do the same for each of its children
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        processNode(node->mChildren[i], scene, options, data);
+    }
+}
+
+void ModelLoader::AttachTextures(MeshData& meshData, aiMaterial* material, const aiScene* scene,
+    const ModelOptions& options) {
+
+    // try Embedded textures first
+    auto findTexture = [&](aiTextureType aiType, TextureRef& ref) -> bool {
+        if (material->GetTextureCount(aiType) == 0) return false;
+
+        aiString texPath;
+        if (material->GetTexture(aiType, 0, &texPath) != AI_SUCCESS) return false;
+        std::cout << "[DEBUG] Raw texture path: \"" << texPath.C_Str() << "\"\n";
+
+        // Embedded texture 
+        if (texPath.length > 0 && texPath.C_Str()[0] == '*') {
+            int idx = std::atoi(texPath.C_Str() + 1);
+            if (idx >= 0 && idx < (int)scene->mNumTextures) {
+                const aiTexture* tex = scene->mTextures[idx];
+                if (!tex) return false;
+
+                // Compressed embedded texture (GLB case)
+                if (tex->mHeight == 0) {
+                    ref.source = TextureRef::Source::Embedded;
+                    ref.embeddedIndex = idx;
+                    return true;
+                }
+            }
+        }
+        return false;
+        };
+
+    // Try to find diffuse texture (slot 0)
+    bool hasDiffuse = findTexture(aiTextureType_BASE_COLOR, meshData.diffuse) ||
+                      findTexture(aiTextureType_DIFFUSE, meshData.diffuse);
+
+    // Try to find specular texture (slot 1)
+    bool hasSpecular = findTexture(aiTextureType_SPECULAR, meshData.specular);
+
+	// attempt manual override paths if provided
+    if (!hasDiffuse && !options.diffusePath.empty()) {
+        meshData.diffuse.source = TextureRef::Source::File;
+        meshData.diffuse.path = options.diffusePath;
+        hasDiffuse = true;
+    }
+
+    if (!hasSpecular && !options.specularPath.empty()) {
+        meshData.specular.source = TextureRef::Source::File;
+        meshData.specular.path = options.specularPath;
+        hasSpecular = true;
+    }
+
+
+    if (!hasDiffuse) {
+        std::cout << "[Texture] Warning: No diffuse texture found\n";
+    }
+    if (!hasSpecular) {
+        std::cout << "[Texture] Note: No specular texture found\n";
+    }
+}
+
+MeshData ModelLoader::processMesh(aiMesh* mesh, const aiScene* scene, const ModelOptions& options) {
+    MeshData data;
+    data.hasColor = mesh->HasVertexColors(0);
+    data.vertices.reserve(mesh->mNumVertices);
+    data.indices.reserve(mesh->mNumFaces * 3);
+
+    // extract vertex data
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+        Vertex vertex;
+        
+        // Vertex position
+        vertex.position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+        // Normals (if they exist)
+        if (mesh->HasNormals())
+            vertex.normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        else
+            vertex.normal = glm::vec3(0.0f);
+
+        // Texture coordinates
+        if (mesh->HasTextureCoords(0))
+            vertex.texUV = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        else
+            vertex.texUV = glm::vec2(0.0f);
+
+        // Vertex color if the source has one
+        if (mesh->HasVertexColors(0))
+            vertex.color = glm::vec3(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b);
+        else
+            vertex.color = glm::vec3(1.0f); // Default white
+
+        // expand mesh-space AABB
+        data.aabbMin = glm::min(data.aabbMin, vertex.position);
+        data.aabbMax = glm::max(data.aabbMax, vertex.position);
+
+        data.vertices.push_back(vertex);
+    }
+
+    // process indices
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        aiFace face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++) {
+            data.indices.push_back(static_cast<GLuint>(face.mIndices[j]));
+        }
+    }
+
+    // resolve where the textures come from (decoded later)
+    if (mesh->mMaterialIndex < scene->mNumMaterials) {
+        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        AttachTextures(data, material, scene, options);
+    }
+
+    return data;
+}
+
+// -------------------- GL stage --------------------
+
+bool ModelLoader::uploadNext(LoadJob& job) {
+    if (!job.ok || job.nextMesh >= job.view.meshes.size()) return true;
+
+    size_t i = job.nextMesh++;
+    const MeshView& mv = job.view.meshes[i];
+
+    std::vector<std::shared_ptr<Texture>> textures;
+    if (auto tex = acquireTexture(job, mv.diffuse, "diffuse", 0)) textures.push_back(tex);
+    if (auto tex = acquireTexture(job, mv.specular, "specular", 1)) textures.push_back(tex);
+
+    // construct Mesh in place once and transfer ownership into the asset
+    job.asset->meshes.emplace_back(std::make_shared<Mesh>(mv, textures));
+    return job.nextMesh >= job.view.meshes.size();
+}
+
+std::shared_ptr<Texture> ModelLoader::acquireTexture(LoadJob& job, const TextureRef& ref,
+    const char* typeName, GLuint slot) {
+    std::string key = textureKey(ref, job.path, typeName);
+    if (key.empty()) return nullptr;
+
+    // shared with an earlier mesh or model
+    TextureCache& cache = TextureCache::Instance();
+    if (std::shared_ptr<Texture> cached = cache.Find(key)) return cached;
+
+    // file textures keep their pixelated look, embedded ones are filtered
+    GLenum filter = ref.source == TextureRef::Source::File ? GL_NEAREST : GL_LINEAR;
+
+    // decoded on the thread pool and uploaded through the PBO ring later
+    TextureStreamer& streamer = TextureStreamer::Instance();
+    std::shared_ptr<Texture> texture;
+    if (ref.source == TextureRef::Source::Embedded) {
+        if (ref.embeddedIndex < 0 || ref.embeddedIndex >= (int)job.view.embeddedTextures.size()) return nullptr;
+        const ByteView& bytes = job.view.embeddedTextures[ref.embeddedIndex];
+        if (bytes.size == 0) return nullptr;
+        texture = streamer.Request(bytes.data, bytes.size, typeName, slot, filter);
+    }
+    else {
+        texture = streamer.Request(ref.path, typeName, slot, filter);
+    }
+    std::cout << "[Texture] Streaming " << typeName << ": " << key << "\n";
+    cache.Store(key, texture);
+    return texture;
+}
+
+void ModelLoader::finish(LoadJob& job) {
+    job.asset->aabbMin = job.view.aabbMin;
+    job.asset->aabbMax = job.view.aabbMax;
+    if (job.ok) AssetCache::Instance().Store(job.key, job.asset);
+
+    if (job.handle) {
+        job.handle->asset = job.asset;
+        job.handle->state = job.ok ? PendingModel::Ready : PendingModel::Failed;
+        inFlight.erase(job.key);
+    }
+}
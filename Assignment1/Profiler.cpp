@@ -0,0 +1,275 @@
+#include "Profiler.h"
+#include <imgui.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+
+bool Profiler::enabled = true;
+
+namespace {
+
+double nowMs() {
+	using clock = std::chrono::steady_clock;
+	static const clock::time_point origin = clock::now();
+	return std::chrono::duration<double, std::milli>(clock::now() - origin).count();
+}
+
+// stable colour per zone name
+ImU32 zoneColor(const char* name) {
+	uint32_t h = 2166136261u;
+	for (const char* c = name; *c; ++c) h = (h ^ (unsigned char)*c) * 16777619u;
+	return ImColor::HSV((h % 360) / 360.0f, 0.55f, 0.75f);
+}
+
+} // namespace
+
+Profiler& Profiler::Instance() {
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler() {
+	// negative samples are "no data" and skipped by the statistics
+	std::fill(frameCpu, frameCpu + HISTORY, -1.0f);
+	std::fill(frameGpu, frameGpu + HISTORY, -1.0f);
+}
+
+void Profiler::BeginFrame() {
+	if (!enabled || inFrame) return;
+	Frame& frame = frames[current];
+	// the queries of this slot were issued LATENCY frames ago
+	if (frame.pending) {
+		resolve(frame);
+		if (!paused) record(frame);
+		frame.pending = false;
+	}
+	frame.zones.clear();
+	frame.usedQueries = 0;
+	stack.clear();
+	frameStart = nowMs();
+	inFrame = true;
+	// the whole frame is the root zone, GPU times are relative to its start
+	BeginZone("Frame");
+}
+
+void Profiler::EndFrame() {
+	if (!inFrame) return;
+	while (!stack.empty()) EndZone();
+	Frame& frame = frames[current];
+	frame.pending = true;
+	inFrame = false;
+	current = (current + 1) % LATENCY;
+}
+
+bool Profiler::BeginZone(const char* name, bool gpu) {
+	if (!enabled || !inFrame) return false;
+	Frame& frame = frames[current];
+	Zone zone;
+	zone.name = name;
+	zone.depth = (int)stack.size();
+	zone.cpuBegin = nowMs() - frameStart;
+	zone.cpuEnd = zone.cpuBegin;
+	if (gpu) zone.gpuBegin = timestamp(frame);
+	stack.push_back((int)frame.zones.size());
+	frame.zones.push_back(zone);
+	return true;
+}
+
+void Profiler::EndZone() {
+	if (!inFrame || stack.empty()) return;
+	Frame& frame = frames[current];
+	Zone& zone = frame.zones[stack.back()];
+	stack.pop_back();
+	if (zone.gpuBegin >= 0) zone.gpuEnd = timestamp(frame);
+	zone.cpuEnd = nowMs() - frameStart;
+}
+
+int Profiler::timestamp(Frame& frame) {
+	if (frame.usedQueries == (int)frame.queries.size()) {
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+	int index = frame.usedQueries++;
+	glQueryCounter(frame.queries[index], GL_TIMESTAMP);
+	return index;
+}
+
+void Profiler::resolve(Frame& frame) {
+	frame.cpuMs = frame.zones.empty() ? 0.0 : frame.zones[0].cpuEnd;
+	frame.hasGpu = false;
+	if (frame.usedQueries == 0) return;
+
+	// timestamps complete in order, the last one being ready means all are
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available) {
+		dropped++;
+		return;
+	}
+	std::vector<GLuint64> times(frame.usedQueries);
+	for (int i = 0; i < frame.usedQueries; ++i)
+		glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &times[i]);
+
+	GLuint64 base = times[frame.zones[0].gpuBegin];
+	for (Zone& zone : frame.zones) {
+		if (zone.gpuBegin < 0 || zone.gpuEnd < 0) continue;
+		zone.gpuBeginMs = (times[zone.gpuBegin] - base) / 1e6;
+		zone.gpuEndMs = (times[zone.gpuEnd] - base) / 1e6;
+	}
+	frame.gpuMs = frame.zones[0].gpuEndMs;
+	frame.hasGpu = true;
+}
+
+Profiler::History& Profiler::historyFor(const char* name) {
+	for (History& h : histories) {
+		if (h.name == name || std::strcmp(h.name, name) == 0) return h;
+	}
+	History h;
+	h.name = name;
+	std::fill(h.cpu, h.cpu + HISTORY, -1.0f);
+	std::fill(h.gpu, h.gpu + HISTORY, -1.0f);
+	histories.push_back(h);
+	return histories.back();
+}
+
+void Profiler::record(const Frame& frame) {
+	// zones missing from this frame get no sample
+	for (History& h : histories) {
+		h.cpu[historyHead] = -1.0f;
+		h.gpu[historyHead] = -1.0f;
+	}
+	for (const Zone& zone : frame.zones) {
+		History& h = historyFor(zone.name);
+		// a zone entered several times in a frame adds up
+		float cpu = (float)(zone.cpuEnd - zone.cpuBegin);
+		h.cpu[historyHead] = std::max(h.cpu[historyHead], 0.0f) + cpu;
+		if (frame.hasGpu && zone.gpuEnd >= 0) {
+			float gpu = (float)(zone.gpuEndMs - zone.gpuBeginMs);
+			h.gpu[historyHead] = std::max(h.gpu[historyHead], 0.0f) + gpu;
+		}
+	}
+	frameCpu[historyHead] = (float)frame.cpuMs;
+	frameGpu[historyHead] = frame.hasGpu ? (float)frame.gpuMs : -1.0f;
+	historyHead = (historyHead + 1) % HISTORY;
+	shown = frame;
+}
+
+Profiler::Stats Profiler::computeStats(const float* samples) {
+	std::vector<float> v;
+	v.reserve(HISTORY);
+	for (int i = 0; i < HISTORY; ++i) {
+		if (samples[i] >= 0.0f) v.push_back(samples[i]);
+	}
+	Stats s;
+	if (v.empty()) return s;
+	std::sort(v.begin(), v.end());
+	double sum = 0.0;
+	for (float x : v) sum += x;
+	// nearest-rank percentiles
+	auto percentile = [&](double p) {
+		size_t rank = (size_t)std::ceil(p * v.size());
+		return v[std::min(v.size(), std::max<size_t>(rank, 1)) - 1];
+	};
+	s.min = v.front();
+	s.avg = (float)(sum / v.size());
+	s.p95 = percentile(0.95);
+	s.p99 = percentile(0.99);
+	return s;
+}
+
+void Profiler::drawTimeline(const Frame& frame, bool gpu) {
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	int depth = 0;
+	for (const Zone& zone : frame.zones) depth = std::max(depth, zone.depth + 1);
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvail().x, 50.0f);
+	ImGui::Dummy(ImVec2(width, depth * rowHeight));
+
+	double span = gpu ? frame.gpuMs : frame.cpuMs;
+	if (span <= 0.0) return;
+	ImDrawList* draw = ImGui::GetWindowDrawList();
+	for (const Zone& zone : frame.zones) {
+		if (gpu && zone.gpuEnd < 0) continue;
+		double begin = gpu ? zone.gpuBeginMs : zone.cpuBegin;
+		double end = gpu ? zone.gpuEndMs : zone.cpuEnd;
+		ImVec2 a(origin.x + (float)(begin / span) * width, origin.y + zone.depth * rowHeight);
+		// keep very short zones visible
+		ImVec2 b(std::max(origin.x + (float)(end / span) * width, a.x + 1.0f), a.y + rowHeight - 1.0f);
+		draw->AddRectFilled(a, b, zoneColor(zone.name));
+		draw->PushClipRect(a, b, true);
+		draw->AddText(ImVec2(a.x + 2.0f, a.y + 2.0f), IM_COL32(255, 255, 255, 255), zone.name);
+		draw->PopClipRect();
+		if (ImGui::IsMouseHoveringRect(a, b)) ImGui::SetTooltip("%s: %.3f ms", zone.name, end - begin);
+	}
+}
+
+void Profiler::DrawGUI() {
+	// to the right of "Lighting Controls"
+	ImGui::SetNextWindowPos(ImVec2(800, 10), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(390, 560), ImGuiCond_FirstUseEver);
+	ImGui::Begin("Profiler");
+	ImGui::Checkbox("Enabled", &enabled);
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &paused);
+
+	const Stats cpu = computeStats(frameCpu);
+	const Stats gpu = computeStats(frameGpu);
+	ImGui::Text("Frame: %.2f ms CPU (p99 %.2f), %.2f ms GPU (p99 %.2f)", cpu.avg, cpu.p99, gpu.avg, gpu.p99);
+	ImGui::Text("GPU readbacks dropped: %zu", dropped);
+
+	float scale = std::max(std::max(cpu.p99, gpu.p99) * 1.25f, 1.0f);
+	ImGui::PlotLines("##frameCpu", frameCpu, HISTORY, historyHead, "CPU ms", 0.0f, scale, ImVec2(-1.0f, 50.0f));
+	ImGui::PlotLines("##frameGpu", frameGpu, HISTORY, historyHead, "GPU ms", 0.0f, scale, ImVec2(-1.0f, 50.0f));
+	ImGui::Separator();
+
+	ImGui::Text("CPU timeline (%.2f ms)", shown.cpuMs);
+	drawTimeline(shown, false);
+	if (shown.hasGpu) {
+		ImGui::Text("GPU timeline (%.2f ms)", shown.gpuMs);
+		drawTimeline(shown, true);
+	}
+	ImGui::Separator();
+
+	ImGui::RadioButton("CPU", &statsSource, 0);
+	ImGui::SameLine();
+	ImGui::RadioButton("GPU", &statsSource, 1);
+	if (ImGui::BeginTable("zones", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+		ImGui::TableSetupColumn("Zone (ms)");
+		ImGui::TableSetupColumn("min");
+		ImGui::TableSetupColumn("avg");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableHeadersRow();
+		for (const History& h : histories) {
+			Stats s = computeStats(statsSource ? h.gpu : h.cpu);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(h.name);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", s.min);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", s.avg);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", s.p95);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", s.p99);
+		}
+		ImGui::EndTable();
+	}
+	ImGui::End();
+}
+
+void Profiler::Delete() {
+	for (Frame& frame : frames) {
+		if (!frame.queries.empty()) glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+		frame.queries.clear();
+		frame.usedQueries = 0;
+		frame.pending = false;
+	}
+	inFrame = false;
+}
+
+ProfileZone::ProfileZone(const char* name, bool gpu)
+	: active(Profiler::Instance().BeginZone(name, gpu)) {
+}
+
+ProfileZone::~ProfileZone() {
+	if (active) Profiler::Instance().EndZone();
+}
@@ -0,0 +1,109 @@
+#include "ProgramCache.h"
+#include "FileUtils.h"
+#include "GLExt.h"
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+// Key hashes VERSION by address, so it needs a definition
+const uint32_t ProgramCache::VERSION;
+const char* ProgramCache::DIRECTORY = "Cache/shaders";
+size_t ProgramCache::hits = 0;
+size_t ProgramCache::misses = 0;
+size_t ProgramCache::rejected = 0;
+
+namespace {
+	const char MAGIC[4] = { 'R', 'T', 'R', 'P' };
+
+	struct ProgramHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t length;
+	};
+
+	std::string glString(GLenum name) {
+		const GLubyte* s = glGetString(name);
+		return s ? reinterpret_cast<const char*>(s) : "";
+	}
+}
+
+std::string ProgramCache::cachePath(uint64_t key) {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return std::string(DIRECTORY) + "/" + name;
+}
+
+uint64_t ProgramCache::Key(const std::string& vertexSource, const std::string& fragmentSource,
+	const std::string& defines) {
+	// binaries are only valid for the driver that produced them
+	static const std::string driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+	uint64_t h = hashString(driver);
+	// lengths keep "ab"+"c" and "a"+"bc" apart
+	for (const std::string* s : { &vertexSource, &fragmentSource, &defines }) {
+		uint64_t length = s->size();
+		h = hashBytes(&length, sizeof(length), h);
+		h = hashString(*s, h);
+	}
+	return hashBytes(&VERSION, sizeof(VERSION), h);
+}
+
+bool ProgramCache::Load(uint64_t key, GLuint program) {
+	if (!GLExt::hasProgramBinary) return false;
+	std::vector<unsigned char> bytes;
+	if (!readFileBytes(cachePath(key), bytes) || bytes.size() < sizeof(ProgramHeader)) {
+		misses++;
+		return false;
+	}
+	ProgramHeader header;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.key != key
+		|| bytes.size() != sizeof(header) + header.length) {
+		misses++;
+		return false;
+	}
+
+	glProgramBinary(program, header.binaryFormat, bytes.data() + sizeof(header), (GLsizei)header.length);
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		// the driver changed in a way the version string doesn't show
+		rejected++;
+		misses++;
+		return false;
+	}
+	hits++;
+	return true;
+}
+
+bool ProgramCache::Save(uint64_t key, GLuint program) {
+	if (!GLExt::hasProgramBinary) return false;
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return false;
+
+	std::vector<unsigned char> bytes(sizeof(ProgramHeader) + length);
+	GLenum binaryFormat = 0;
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &binaryFormat, bytes.data() + sizeof(ProgramHeader));
+	if (written <= 0) return false;
+
+	ProgramHeader header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.key = key;
+	header.binaryFormat = binaryFormat;
+	header.length = (uint32_t)written;
+	std::memcpy(bytes.data(), &header, sizeof(header));
+	bytes.resize(sizeof(header) + written);
+
+	ensureDirectory("Cache");
+	ensureDirectory(DIRECTORY);
+	if (!writeFileAtomic(cachePath(key), bytes.data(), bytes.size())) {
+		std::cerr << "[ProgramCache] failed to write " << cachePath(key) << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,219 @@
+#include "RegressionSuite.h"
+#include "FileUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+struct Lab {
+	float l, a, b;
+};
+
+float labCurve(float t) {
+	return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+}
+
+// sRGB8 -> CIE L*a*b* (D65)
+Lab toLab(const unsigned char* rgb) {
+	static float linear[256];
+	static bool tableReady = false;
+	if (!tableReady) {
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		tableReady = true;
+	}
+	float r = linear[rgb[0]], g = linear[rgb[1]], b = linear[rgb[2]];
+	float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+	float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+	float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+	float fx = labCurve(x), fy = labCurve(y), fz = labCurve(z);
+	return { 116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz) };
+}
+
+// RGBA8 bottom row first (glReadPixels) -> RGB8 top row first
+std::vector<unsigned char> toTopDownRGB(const std::vector<unsigned char>& rgba, int width, int height) {
+	std::vector<unsigned char> rgb((size_t)width * height * 3);
+	for (int y = 0; y < height; y++) {
+		const unsigned char* src = &rgba[(size_t)(height - 1 - y) * width * 4];
+		unsigned char* dst = &rgb[(size_t)y * width * 3];
+		for (int x = 0; x < width; x++) {
+			dst[x * 3 + 0] = src[x * 4 + 0];
+			dst[x * 3 + 1] = src[x * 4 + 1];
+			dst[x * 3 + 2] = src[x * 4 + 2];
+		}
+	}
+	return rgb;
+}
+
+} // namespace
+
+RegressionOptions RegressionOptions::Parse(int argc, char** argv) {
+	RegressionOptions options;
+	for (int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--regression") == 0) options.enabled = true;
+		else if (std::strcmp(argv[i], "--update") == 0) options.update = true;
+		else if (std::strcmp(argv[i], "--refs") == 0 && hasValue) options.directory = argv[++i];
+		else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue) options.tolerance = (float)std::atof(argv[++i]);
+		else if (std::strcmp(argv[i], "--slack") == 0 && hasValue) options.slack = (float)std::atof(argv[++i]);
+	}
+	return options;
+}
+
+RegressionSuite::RegressionSuite(const RegressionOptions& options)
+	: options(options) {
+	if (options.update) ensureDirectory(options.directory);
+	else loadBudgets();
+}
+
+bool RegressionSuite::fail(const std::string& name, const std::string& reason) {
+	std::cerr << "[Regression] FAIL " << name << ": " << reason << std::endl;
+	failed++;
+	return false;
+}
+
+bool RegressionSuite::CheckImage(const std::string& name, const std::vector<unsigned char>& rgba, int width, int height) {
+	std::vector<unsigned char> rgb = toTopDownRGB(rgba, width, height);
+	std::string path = options.directory + "/" + name + ".ppm";
+	if (options.update) {
+		if (!WritePPM(path, rgb, width, height)) return fail(name, "can't write " + path);
+		std::cout << "[Regression] stored " << path << std::endl;
+		passed++;
+		return true;
+	}
+
+	std::vector<unsigned char> reference;
+	int refWidth = 0, refHeight = 0;
+	if (!ReadPPM(path, reference, refWidth, refHeight)) return fail(name, "no reference image " + path);
+	if (refWidth != width || refHeight != height) return fail(name, "reference has a different size");
+
+	double meanDelta = 0.0, badFraction = 0.0;
+	std::vector<unsigned char> heatMap;
+	Compare(reference, rgb, options.tolerance, meanDelta, badFraction, &heatMap);
+	if (badFraction > options.maxBadPixels) {
+		// keep the output and where it differs for inspection
+		std::string failedDir = options.directory + "/failed";
+		ensureDirectory(failedDir);
+		WritePPM(failedDir + "/" + name + ".ppm", rgb, width, height);
+		WritePPM(failedDir + "/" + name + "_diff.ppm", heatMap, width, height);
+		std::ostringstream reason;
+		reason << badFraction * 100.0 << "% of pixels differ (mean dE " << meanDelta << ")";
+		return fail(name, reason.str());
+	}
+	std::cout << "[Regression] ok " << name << " (mean dE " << meanDelta << ")" << std::endl;
+	passed++;
+	return true;
+}
+
+bool RegressionSuite::CheckBudget(const std::string& name, double frameMs, size_t drawCalls) {
+	measured[name] = { frameMs, drawCalls };
+	if (options.update) {
+		passed++;
+		return true;
+	}
+	auto it = budgets.find(name);
+	if (it == budgets.end()) return fail(name, "no recorded budget");
+
+	const Budget& budget = it->second;
+	std::ostringstream reason;
+	if (drawCalls > budget.drawCalls) {
+		reason << drawCalls << " draw calls, budget " << budget.drawCalls;
+		return fail(name, reason.str());
+	}
+	if (frameMs > budget.frameMs * (1.0 + options.slack)) {
+		reason << "p95 " << frameMs << " ms, budget " << budget.frameMs << " ms +" << options.slack * 100.0f << "%";
+		return fail(name, reason.str());
+	}
+	std::cout << "[Regression] ok " << name << " (p95 " << frameMs << " ms / " << budget.frameMs
+		<< " ms, " << drawCalls << " draws)" << std::endl;
+	passed++;
+	return true;
+}
+
+bool RegressionSuite::Finish() {
+	if (options.update) {
+		// one entry per line, loadBudgets reads it back line by line
+		std::ostringstream out;
+		out << "{\n";
+		size_t i = 0;
+		for (const auto& entry : measured) {
+			out << "  \"" << entry.first << "\": { \"frameMs\": " << entry.second.frameMs
+				<< ", \"drawCalls\": " << entry.second.drawCalls << " }" << (++i < measured.size() ? "," : "") << "\n";
+		}
+		out << "}\n";
+		std::string text = out.str();
+		if (!writeFileAtomic(budgetPath(), text.data(), text.size())) fail("budget", "can't write " + budgetPath());
+	}
+	std::cout << "[Regression] " << passed << " passed, " << failed << " failed" << std::endl;
+	return failed == 0;
+}
+
+void RegressionSuite::loadBudgets() {
+	std::ifstream in(budgetPath());
+	std::string line;
+	while (std::getline(in, line)) {
+		char name[128];
+		Budget budget;
+		unsigned long long draws = 0;
+		if (std::sscanf(line.c_str(), " \"%127[^\"]\": { \"frameMs\": %lf, \"drawCalls\": %llu",
+			name, &budget.frameMs, &draws) == 3) {
+			budget.drawCalls = (size_t)draws;
+			budgets[name] = budget;
+		}
+	}
+}
+
+void RegressionSuite::Compare(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b,
+	float tolerance, double& meanDelta, double& badFraction, std::vector<unsigned char>* heatMap) {
+	size_t pixels = std::min(a.size(), b.size()) / 3;
+	if (heatMap) heatMap->assign(pixels * 3, 0);
+	double sum = 0.0;
+	size_t bad = 0;
+	for (size_t i = 0; i < pixels; i++) {
+		Lab la = toLab(&a[i * 3]), lb = toLab(&b[i * 3]);
+		float dl = la.l - lb.l, da = la.a - lb.a, db = la.b - lb.b;
+		float delta = std::sqrt(dl * dl + da * da + db * db);
+		sum += delta;
+		if (delta > tolerance) bad++;
+		if (heatMap) {
+			// dimmed reference, failing pixels in red scaled by the difference
+			unsigned char grey = (unsigned char)(la.l * 0.8f);
+			unsigned char* out = &(*heatMap)[i * 3];
+			out[0] = delta > tolerance ? (unsigned char)std::min(255.0f, 128.0f + delta * 4.0f) : grey;
+			out[1] = delta > tolerance ? 0 : grey;
+			out[2] = delta > tolerance ? 0 : grey;
+		}
+	}
+	meanDelta = pixels ? sum / pixels : 0.0;
+	badFraction = pixels ? (double)bad / pixels : 0.0;
+}
+
+bool RegressionSuite::ReadPPM(const std::string& path, std::vector<unsigned char>& rgb, int& width, int& height) {
+	std::vector<unsigned char> bytes;
+	if (!readFileBytes(path, bytes)) return false;
+	std::string header(bytes.begin(), bytes.begin() + std::min<size_t>(bytes.size(), 64));
+	int maxValue = 0, consumed = 0;
+	if (std::sscanf(header.c_str(), "P6 %d %d %d%n", &width, &height, &maxValue, &consumed) != 3 || maxValue != 255)
+		return false;
+	// a single whitespace byte separates the header from the pixels
+	size_t offset = (size_t)consumed + 1;
+	size_t size = (size_t)width * height * 3;
+	if (width <= 0 || height <= 0 || bytes.size() < offset + size) return false;
+	rgb.assign(bytes.begin() + offset, bytes.begin() + offset + size);
+	return true;
+}
+
+bool RegressionSuite::WritePPM(const std::string& path, const std::vector<unsigned char>& rgb, int width, int height) {
+	std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+	std::vector<unsigned char> bytes(header.begin(), header.end());
+	bytes.insert(bytes.end(), rgb.begin(), rgb.end());
+	return writeFileAtomic(path, bytes.data(), bytes.size());
+}
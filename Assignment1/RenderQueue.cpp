@@ -0,0 +1,282 @@
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "Mesh.h"
+#include "GLState.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// a mesh's texture set, its first texture stands in for the whole set
+uint32_t textureSet(const Mesh& mesh) {
+	return mesh.textures.empty() ? 0u : mesh.textures[0]->ID;
+}
+
+// positive floats sort like their bit patterns, keep the top 24 bits
+uint32_t depthBits(float depth) {
+	if (!(depth > 0.0f)) return 0u;
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> 8;
+}
+
+} // namespace
+
+uint64_t RenderQueue::MakeKey(Pass pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth) {
+	uint32_t d = depthBits(depth);
+	// transparent surfaces blend back to front
+	if (pass == Transparent) d = 0xFFFFFFu - d;
+	return (uint64_t(pass & 0x3u) << 62)
+		| (uint64_t(shader & 0x3FFu) << 52)
+		| (uint64_t(material & 0xFFFu) << 40)
+		| (uint64_t(mesh & 0xFFFFu) << 24)
+		| uint64_t(d & 0xFFFFFFu);
+}
+
+void RenderQueue::add(Pass pass, const Command& command, float depth) {
+	// textures in the low bits, material index above them
+	uint32_t material = (textureSet(*command.mesh) & 0xFFu) | (uint32_t(command.material & 0xF) << 8);
+	SortItem item;
+	item.key = MakeKey(pass, command.shader->ID, material, command.mesh->vertexArray(), depth);
+	item.command = static_cast<uint32_t>(commands.size());
+	items.push_back(item);
+	commands.push_back(command);
+}
+
+void RenderQueue::Submit(Pass pass, Shader& shader, Mesh& mesh, const glm::mat4& model, float depth,
+	size_t lod, int material) {
+	Command c;
+	c.shader = &shader.Resolve();
+	c.mesh = &mesh;
+	c.model = model;
+	c.lod = lod;
+	c.material = material;
+	c.clusters = false;
+	add(pass, c, depth);
+}
+
+void RenderQueue::SubmitClusters(Pass pass, Shader& shader, Mesh& mesh, const glm::mat4& model, float depth,
+	const Frustum& frustum, const glm::vec3& localCamera, int material) {
+	Command c;
+	c.shader = &shader.Resolve();
+	c.mesh = &mesh;
+	c.model = model;
+	c.lod = 0;
+	c.material = material;
+	c.clusters = true;
+	c.frustum = frustum;
+	c.localCamera = localCamera;
+	add(pass, c, depth);
+}
+
+void RenderQueue::Sort() {
+	RadixSort(items, scratch);
+}
+
+void RenderQueue::RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch) {
+	size_t count = items.size();
+	if (count < 2) return;
+	// the histogram passes only pay off for larger queues
+	if (count < 256) {
+		std::sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+		return;
+	}
+	scratch.resize(count);
+
+	// histograms of all 8 digits in one pass
+	uint32_t histograms[8][256];
+	std::memset(histograms, 0, sizeof(histograms));
+	for (const SortItem& item : items) {
+		uint64_t key = item.key;
+		for (int digit = 0; digit < 8; ++digit) histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+	}
+
+	SortItem* src = items.data();
+	SortItem* dst = scratch.data();
+	for (int digit = 0; digit < 8; ++digit) {
+		uint32_t* h = histograms[digit];
+		int shift = digit * 8;
+		// every key has the same byte here (e.g. unused shader bits), nothing to do
+		if (h[(src[0].key >> shift) & 0xFF] == count) continue;
+
+		uint32_t offsets[256];
+		uint32_t sum = 0;
+		for (int b = 0; b < 256; ++b) {
+			offsets[b] = sum;
+			sum += h[b];
+		}
+		// stable scatter keeps the order of the lower digits
+		for (size_t i = 0; i < count; ++i) dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+		std::swap(src, dst);
+	}
+	// an odd number of passes leaves the result in scratch
+	if (src != items.data()) items.swap(scratch);
+}
+
+bool RenderQueue::multiDraw = false;
+
+void RenderQueue::Execute() {
+	shaderSwitches = 0;
+	meshSwitches = 0;
+	drawCalls = 0;
+	if (multiDraw && GLExt::hasMultiDrawIndirect) executeBatched();
+	else executeDirect();
+}
+
+void RenderQueue::useShader(Shader*& current, Shader* shader) {
+	if (shader == current) return;
+	current = shader;
+	current->Activate();
+	shaderSwitches++;
+}
+
+void RenderQueue::executeDirect() {
+	Shader* shader = nullptr;
+	Mesh* mesh = nullptr;
+	int material = -1;
+	for (const SortItem& item : items) {
+		Command& c = commands[item.command];
+		if (c.shader != shader) {
+			useShader(shader, c.shader);
+			material = -1; // uniforms are per program
+		}
+		if (c.material != material) {
+			material = c.material;
+			shader->setInt("material", material);
+		}
+		if (c.mesh != mesh) {
+			mesh = c.mesh;
+			meshSwitches++;
+		}
+		shader->setModelMatrix(c.model);
+		if (c.clusters) c.mesh->DrawClusters(*shader, c.frustum, c.localCamera);
+		else c.mesh->Draw(*shader, c.lod);
+		drawCalls++;
+	}
+}
+
+void RenderQueue::executeBatched() {
+	Shader* shader = nullptr;
+	Mesh* mesh = nullptr;
+	for (const SortItem& item : items) {
+		Command& c = commands[item.command];
+		if (c.mesh != mesh) {
+			mesh = c.mesh;
+			meshSwitches++;
+		}
+		GeometryPool* pool = GeometryPool::Acquire(*c.mesh);
+		if (!pool) {
+			// can't be pooled: draw it on its own
+			flushBatch();
+			useShader(shader, c.shader);
+			c.shader->setInt("material", c.material);
+			c.shader->setModelMatrix(c.model);
+			if (c.clusters) c.mesh->DrawClusters(*c.shader, c.frustum, c.localCamera);
+			else c.mesh->Draw(*c.shader, c.lod);
+			drawCalls++;
+			continue;
+		}
+		// a batch shares the program, the buffers and the bound textures
+		if (c.shader != batchShader || pool != batchPool || c.mesh->textures != batchMesh->textures) {
+			flushBatch();
+			useShader(shader, c.shader);
+			batchShader = c.shader;
+			batchPool = pool;
+			batchMesh = c.mesh;
+		}
+
+		// the draw's data is found through baseInstance
+		DrawData data;
+		data.model = c.model;
+		glm::mat3 normal = Shader::NormalMatrix(c.model);
+		for (int col = 0; col < 3; col++) data.normalMatrix[col] = glm::vec4(normal[col], 0.0f);
+		data.posScale = glm::vec4(c.mesh->posScale, 0.0f);
+		data.posOffset = glm::vec4(c.mesh->posOffset, 0.0f);
+		data.materialIndex = c.material;
+		data.padding[0] = data.padding[1] = data.padding[2] = 0;
+		GLuint drawIndex = static_cast<GLuint>(batchDraws.size());
+
+		DrawElementsIndirectCommand cmd;
+		cmd.instanceCount = 1;
+		cmd.baseVertex = c.mesh->poolBaseVertex;
+		cmd.baseInstance = drawIndex;
+		if (c.clusters && !c.mesh->clusters.empty()) {
+			// one command per visible cluster range
+			c.mesh->clusters.Cull(c.frustum, c.localCamera, cullCounts, cullOffsets);
+			if (cullCounts.empty()) continue;
+			for (size_t r = 0; r < cullCounts.size(); ++r) {
+				cmd.count = static_cast<GLuint>(cullCounts[r]);
+				cmd.firstIndex = c.mesh->poolFirstIndex + static_cast<GLuint>(
+					reinterpret_cast<size_t>(cullOffsets[r]) / sizeof(GLuint));
+				batchCommands.push_back(cmd);
+			}
+		}
+		else {
+			const MeshLod& range = c.mesh->lods[std::min(c.lod, c.mesh->lods.size() - 1)];
+			cmd.count = range.indexCount;
+			cmd.firstIndex = c.mesh->poolFirstIndex + range.firstIndex;
+			batchCommands.push_back(cmd);
+		}
+		batchDraws.push_back(data);
+	}
+	flushBatch();
+}
+
+void RenderQueue::flushBatch() {
+	if (!batchCommands.empty()) {
+		// textures and octNormals of the first mesh, per-draw values come from the pool
+		batchMesh->BindMaterial(*batchShader);
+		batchShader->setBool("batched", true);
+		batchShader->setModelMatrix(glm::mat4(1.0f));
+		batchPool->MultiDraw(GL_TRIANGLES, batchCommands, batchDraws);
+		batchShader->setBool("batched", false);
+		drawCalls++;
+	}
+	batchCommands.clear();
+	batchDraws.clear();
+	batchShader = nullptr;
+	batchPool = nullptr;
+	batchMesh = nullptr;
+}
+
+void RenderQueue::Clear() {
+	commands.clear();
+	items.clear();
+}
+
+// -------------------- Benchmark --------------------
+
+void RenderQueue::Benchmark(size_t count, int iterations) {
+	// a scene-like mix: few shaders, more materials, many meshes, random depths
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<uint32_t> shader(1, 8), material(0, 255), mesh(1, 4000);
+	std::uniform_real_distribution<float> depth(0.5f, 100.0f);
+	std::vector<SortItem> source(count);
+	for (size_t i = 0; i < count; ++i) {
+		Pass pass = (i % 10 == 0) ? Transparent : Opaque;
+		source[i].key = MakeKey(pass, shader(rng), material(rng), mesh(rng), depth(rng));
+		source[i].command = static_cast<uint32_t>(i);
+	}
+
+	std::vector<SortItem> items, scratch;
+	double radixMs = 0.0, stdMs = 0.0;
+	for (int it = 0; it < iterations; ++it) {
+		items = source;
+		auto start = std::chrono::steady_clock::now();
+		RadixSort(items, scratch);
+		radixMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	bool sorted = std::is_sorted(items.begin(), items.end(),
+		[](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+	for (int it = 0; it < iterations; ++it) {
+		items = source;
+		auto start = std::chrono::steady_clock::now();
+		std::sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+		stdMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	std::cout << "[RenderQueue] radix sort: " << count << " items in " << radixMs / iterations << " ms"
+		<< (sorted ? "" : " (NOT SORTED)") << ", std::sort: " << stdMs / iterations << " ms\n";
+}
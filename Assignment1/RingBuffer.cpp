@@ -0,0 +1,118 @@
+#include "RingBuffer.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include <iostream>
+#include <cstring>
+
+RingBuffer& RingBuffer::Shared() {
+	static RingBuffer ring(FRAME_SIZE);
+	return ring;
+}
+
+RingBuffer::RingBuffer(size_t size)
+	: frameSize(size) {
+	GLint align = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+	uniformAlign = align > 0 ? (size_t)align : 256;
+
+	size_t total = frameSize * FRAMES;
+	if (GLExt::hasBufferStorage) {
+		// map once, keep the pointer for the lifetime of the ring
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		vbo.reset(new VBO(total, flags));
+		mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags));
+	}
+	if (!mapped) {
+		// older contexts: stage on the CPU, orphan and upload. Orphaning
+		// already keeps the GPU's copy alive, so one section is enough
+		vbo.reset(new VBO(static_cast<const void*>(nullptr), frameSize));
+		staging.resize(frameSize);
+	}
+	std::cout << "[RingBuffer] " << (mapped ? FRAMES : 1) << " x " << frameSize / 1024 << " KB, "
+		<< (mapped ? "persistent mapped" : "orphaning fallback") << std::endl;
+}
+
+RingBuffer::~RingBuffer() {
+	Delete();
+}
+
+void RingBuffer::BeginFrame() {
+	head = 0;
+	flushed = 0;
+	reportedFull = false;
+	if (fences[frame]) {
+		// usually long signaled, three frames have passed
+		GLenum status = glClientWaitSync(fences[frame], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			stalls++;
+			do {
+				status = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			} while (status == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fences[frame]);
+		fences[frame] = nullptr;
+	}
+	if (!mapped) {
+		// detach the storage the GPU may still read, the driver hands out fresh memory
+		vbo->Bind();
+		glBufferData(GL_ARRAY_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+// Start of this frame's section, the fallback always writes from 0
+size_t RingBuffer::sectionBase() const {
+	return mapped ? frameSize * frame : 0;
+}
+
+void* RingBuffer::Allocate(size_t size, size_t alignment, size_t& offset) {
+	size_t base = sectionBase();
+	size_t absolute = base + head;
+	if (alignment > 1) absolute = (absolute + alignment - 1) / alignment * alignment;
+	if (absolute + size > base + frameSize) {
+		if (!reportedFull) std::cerr << "[RingBuffer] frame section full (" << frameSize << " bytes)\n";
+		reportedFull = true;
+		return nullptr;
+	}
+	offset = absolute;
+	head = absolute + size - base;
+	return mapped ? mapped + absolute : staging.data() + (absolute - base);
+}
+
+void RingBuffer::Flush() {
+	if (mapped || flushed == head) return;
+	// coherent mapping needs nothing, the fallback uploads the new bytes
+	vbo->Update(flushed, staging.data() + flushed, head - flushed);
+	flushed = head;
+}
+
+bool RingBuffer::Write(const void* data, size_t size, size_t alignment, size_t& offset) {
+	void* dst = Allocate(size, alignment, offset);
+	if (!dst) return false;
+	std::memcpy(dst, data, size);
+	Flush();
+	return true;
+}
+
+void RingBuffer::EndFrame() {
+	Flush();
+	lastFrameBytes = head;
+	// orphaned storage needs no fence
+	if (mapped) fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame = (frame + 1) % FRAMES;
+}
+
+void RingBuffer::Delete() {
+	for (GLsync& f : fences) {
+		if (f) glDeleteSync(f);
+		f = nullptr;
+	}
+	if (vbo && vbo->ID != 0) {
+		if (mapped) {
+			vbo->Bind();
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		vbo->Delete();
+		vbo->ID = 0;
+	}
+	mapped = nullptr;
+}
@@ -1,8 +1,15 @@
 #include"Shader.h"
+#include"GLState.h"
+#include"GLExt.h"
+#include"ProgramCache.h"
+#include"FileUtils.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cerrno>
+#include <cmath>
+#include <algorithm>
+#include <map>
 
 // Reads a text file and outputs a string with everything in the text file
 std::string get_file_contents(const char* filename) {
@@ -19,66 +26,254 @@ std::string get_file_contents(const char* filename) {
 	throw(errno);
 }
 
-// Constructor that build the Shader Program from 2 different shaders
-Shader::Shader(const char* vertexFile, const char* fragmentFile) {
-	// Read vertexFile and fragmentFile and store the strings
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
+// Puts the defines right after the #version line (which has to come first).
+// Only defines whose name appears in the source are added, so a stage that
+// ignores a feature compiles to the same source (and ShaderStage) either way.
+static std::string insertDefines(const std::string& source, const std::string& allDefines) {
+	std::string defines;
+	std::istringstream lines(allDefines);
+	std::string line;
+	while (std::getline(lines, line)) {
+		std::istringstream words(line);
+		std::string directive, name;
+		words >> directive >> name;
+		if (directive != "#define" || source.find(name) != std::string::npos) defines += line + "\n";
+	}
+	if (defines.empty()) return source;
+	size_t version = source.find("#version");
+	size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+	if (lineEnd == std::string::npos) return defines + "\n" + source;
+	return source.substr(0, lineEnd + 1) + defines + "\n" + source.substr(lineEnd + 1);
+}
+
+// Reads a shader and splices in the files it #includes ("name", relative to
+// the including file). Every file is included once per stage; files collects
+// the paths read by this stage.
+static std::string readWithIncludes(const std::string& path, std::vector<std::string>& files) {
+	files.push_back(path);
+	std::string source = get_file_contents(path.c_str());
+	size_t slash = path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
 
-	// Convert the shader source strings into character arrays
-	const char* vertexSource = vertexCode.c_str();
-	const char* fragmentSource = fragmentCode.c_str();
+	std::string out;
+	std::istringstream lines(source);
+	std::string line;
+	while (std::getline(lines, line)) {
+		size_t first = line.find_first_not_of(" \t");
+		if (first != std::string::npos && line.compare(first, 8, "#include") == 0) {
+			size_t open = line.find('"', first);
+			size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+			if (close != std::string::npos) {
+				std::string included = directory + line.substr(open + 1, close - open - 1);
+				if (std::find(files.begin(), files.end(), included) == files.end())
+					out += readWithIncludes(included, files);
+				continue;
+			}
+		}
+		out += line;
+		out += '\n';
+	}
+	return out;
+}
 
-	// Compile Vertex Shader
+// Shared Stages
 
-	// Create Vertex Shader Object and get its reference
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	// Attach Vertex Shader source to the Vertex Shader Object
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
-	// Compile the Vertex Shader into machine code
-	glCompileShader(vertexShader);
-	checkCompileErrors(vertexShader, "VERTEX");
+size_t ShaderStage::compiled = 0;
+size_t ShaderStage::shared = 0;
 
-	// Compile Fragment Shader
+std::shared_ptr<ShaderStage> ShaderStage::Get(GLenum type, const std::string& source) {
+	// weak, so the cache itself keeps no shader object alive
+	static std::map<std::pair<GLenum, uint64_t>, std::weak_ptr<ShaderStage>> stages;
+	std::weak_ptr<ShaderStage>& entry = stages[std::make_pair(type, hashString(source))];
+	if (std::shared_ptr<ShaderStage> stage = entry.lock()) {
+		shared++;
+		return stage;
+	}
+	std::shared_ptr<ShaderStage> stage = std::make_shared<ShaderStage>(type, source);
+	entry = stage;
+	return stage;
+}
+
+ShaderStage::ShaderStage(GLenum type, const std::string& source) : type(type) {
+	const char* code = source.c_str();
+	// Create the Shader Object, attach the source and compile it into machine
+	// code (the status is only queried in Check, so the driver can work meanwhile)
+	ID = glCreateShader(type);
+	glShaderSource(ID, 1, &code, NULL);
+	glCompileShader(ID);
+	compiled++;
+}
+
+ShaderStage::~ShaderStage() {
+	glDeleteShader(ID);
+}
+
+bool ShaderStage::Check() {
+	if (checked) return compiledOk;
+	checked = true;
+	GLint success;
+	glGetShaderiv(ID, GL_COMPILE_STATUS, &success);
+	compiledOk = success == GL_TRUE;
+	if (!compiledOk) {
+		GLchar infoLog[1024];
+		glGetShaderInfoLog(ID, 1024, NULL, infoLog);
+		std::cerr << "SHADER COMPILATION ERROR (" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << "):\n"
+			<< infoLog << std::endl;
+	}
+	return compiledOk;
+}
+
+
+// Constructor that build the Shader Program from 2 different shaders
+Shader::Shader(const char* vertexFile, const char* fragmentFile, const std::string& defines, bool async)
+	: vertexPath(vertexFile), fragmentPath(fragmentFile), defines(defines) {
+	submitBuild();
+	// blocking builds wait for the result right away
+	if (!async && building != 0) finishBuild();
+}
+
+// Reads the sources and starts compiling and linking a new program
+void Shader::submitBuild() {
+	// Read vertexFile and fragmentFile (and their includes) and store the strings
+	// each stage is its own compile unit, both may include the same file
+	std::vector<std::string> vertexFiles, fragmentFiles;
+	std::string vertexCode = insertDefines(readWithIncludes(vertexPath, vertexFiles), defines);
+	std::string fragmentCode = insertDefines(readWithIncludes(fragmentPath, fragmentFiles), defines);
+	sourceFiles = vertexFiles;
+	for (const std::string& file : fragmentFiles) {
+		if (std::find(sourceFiles.begin(), sourceFiles.end(), file) == sourceFiles.end()) sourceFiles.push_back(file);
+	}
+
+	// a binary cached by an earlier run skips compiling and linking
+	cacheKey = ProgramCache::Key(vertexCode, fragmentCode, defines);
+	GLuint program = glCreateProgram();
+	if (ProgramCache::Load(cacheKey, program)) {
+		adopt(program);
+		return;
+	}
+	// a rejected binary may leave the program in any state, start over
+	glDeleteProgram(program);
 
-	// Create Fragment Shader Object and get its reference
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	// Attach Fragment Shader source to the Fragment Shader Object
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-	// Compile the Vertex Shader into machine code
-	glCompileShader(fragmentShader);
-	checkCompileErrors(fragmentShader, "FRAGMENT");
+	// Compile the stages, or share ones already compiled from the same source
+	buildVertex = ShaderStage::Get(GL_VERTEX_SHADER, vertexCode);
+	buildFragment = ShaderStage::Get(GL_FRAGMENT_SHADER, fragmentCode);
 
-	// Link Shaders
+	// Link Shaders (errors are only queried once everything is submitted, so
+	// the driver can compile the stages, and other programs, in parallel)
 
 	// Create Shader Program Object and get its reference
-	ID = glCreateProgram();
+	building = glCreateProgram();
 	// Attach the Vertex and Fragment Shaders to the Shader Program
-	glAttachShader(ID, vertexShader);
-	glAttachShader(ID, fragmentShader);
+	glAttachShader(building, buildVertex->ID);
+	glAttachShader(building, buildFragment->ID);
+	// ask the driver to keep the binary around for the cache
+	if (GLExt::hasProgramBinary) glProgramParameteri(building, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	// Wrap-up/Link all the shaders together into the Shader Program
-	glLinkProgram(ID);
-	checkCompileErrors(ID, "PROGRAM");
+	glLinkProgram(building);
+}
+
+// Checks the results of a submitted build
+void Shader::finishBuild() {
+	bool ok = buildVertex->Check();
+	ok = buildFragment->Check() && ok;
+	ok = checkCompileErrors(building, "PROGRAM") && ok;
+
+	// the linked program doesn't need the stages attached anymore
+	glDetachShader(building, buildVertex->ID);
+	glDetachShader(building, buildFragment->ID);
+	GLuint program = building;
+	building = 0;
+
+	if (ok) {
+		ProgramCache::Save(cacheKey, program);
+		adopt(program);
+		// keep the stages alive for programs built later from the same sources
+		vertexStage = std::move(buildVertex);
+		fragmentStage = std::move(buildFragment);
+		return;
+	}
+	buildVertex.reset();
+	buildFragment.reset();
+	glDeleteProgram(program);
+	if (usable) std::cerr << "[Shader] " << fragmentPath << " failed to build, keeping the previous program" << std::endl;
+	else buildFailed = true;
+}
+
+// Makes a linked program the current one, replacing the old program
+void Shader::adopt(GLuint program) {
+	if (ID != 0) {
+		GLState::ForgetProgram(ID);
+		glDeleteProgram(ID);
+		std::cout << "[Shader] reloaded " << vertexPath << " + " << fragmentPath << std::endl;
+	}
+	ID = program;
+	usable = true;
+	buildFailed = false;
+	// locations can move between builds
+	uniformCache.clear();
+}
+
+// Drops a build that is still in flight
+void Shader::cancelBuild() {
+	if (building == 0) return;
+	glDeleteProgram(building);
+	building = 0;
+	buildVertex.reset();
+	buildFragment.reset();
+}
+
+bool Shader::IsReady() {
+	if (building == 0) return true;
+	// without the extension the status query below is what waits
+	if (GLExt::hasParallelShaderCompile) {
+		GLint done = GL_FALSE;
+		glGetProgramiv(building, GL_COMPLETION_STATUS_KHR, &done);
+		if (!done) return false;
+	}
+	finishBuild();
+	return true;
+}
 
-	// Delete the now useless Vertex and Fragment Shader objects
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+void Shader::Reload() {
+	// a newer edit replaces a build still in flight
+	cancelBuild();
+	try {
+		submitBuild();
+	}
+	catch (int error) {
+		// e.g. an editor replacing the file right now
+		std::cerr << "[Shader] can't read " << vertexPath << " / " << fragmentPath << " (errno " << error
+			<< "), keeping the previous program" << std::endl;
+	}
+}
 
+Shader& Shader::Resolve() {
+	if (!usable && fallback) return *fallback;
+	return *this;
 }
 
 // Activates the Shader Program
 void Shader::Activate() {
-	glUseProgram(ID);
+	GLState::UseProgram(ID);
 }
 
 // Deletes the Shader Program
 void Shader::Delete() {
+	cancelBuild();
+	GLState::ForgetProgram(ID);
 	glDeleteProgram(ID);
+	ID = 0;
+	usable = false;
+	// the stages go with the last program holding them
+	vertexStage.reset();
+	fragmentStage.reset();
 }
 
 // Uniform Helper Functions
 
 GLint Shader::getUniformLocation(const std::string& name) const {
+	// no linked program yet, don't cache that
+	if (!usable) return -1;
 	auto it = uniformCache.find(name);
 	if (it != uniformCache.end()) return it->second;
 
@@ -127,11 +322,38 @@ void Shader::setVec3(const std::string& name, const glm::vec3& v) const {
 void Shader::setVec4(const std::string& name, const glm::vec4& v) const {
 	glUniform4f(getUniformLocation(name), v.x, v.y, v.z, v.w);
 }
+void Shader::setModelMatrix(const glm::mat4& model) const {
+	setMat4("model", model);
+	glm::mat3 normal = NormalMatrix(model);
+	glUniformMatrix3fv(getUniformLocation("normalMatrix"), 1, GL_FALSE, &normal[0][0]);
+}
+
+glm::mat3 Shader::NormalMatrix(const glm::mat4& model) {
+	glm::mat3 m(model);
+	// orthogonal axes of equal length: the matrix is its own normal matrix (times a scale)
+	float l0 = glm::dot(m[0], m[0]), l1 = glm::dot(m[1], m[1]), l2 = glm::dot(m[2], m[2]);
+	float eps = 1e-4f * l0;
+	if (std::abs(l0 - l1) <= eps && std::abs(l0 - l2) <= eps
+		&& std::abs(glm::dot(m[0], m[1])) <= eps && std::abs(glm::dot(m[0], m[2])) <= eps
+		&& std::abs(glm::dot(m[1], m[2])) <= eps)
+		return m;
+	return glm::transpose(glm::inverse(m));
+}
+
+
+// Uniform Blocks
+
+void Shader::BindUniformBlock(const char* blockName, GLuint binding) const {
+	// GLSL 330 has no layout(binding=), so blocks are assigned here
+	GLuint index = glGetUniformBlockIndex(ID, blockName);
+	if (index == GL_INVALID_INDEX) return;
+	glUniformBlockBinding(ID, index, binding);
+}
 
 
 // Error Handling
 
-void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
+bool Shader::checkCompileErrors(GLuint shader, const std::string& type) {
 	GLint success;
 	GLchar infoLog[1024];
 
@@ -151,4 +373,5 @@ void Shader::checkCompileErrors(GLuint shader, const std::string& type) {
 				<< infoLog << std::endl;
 		}
 	}
+	return success == GL_TRUE;
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "ShaderVariants.h"
+#include <iostream>
+
+namespace {
+
+const char* const FEATURE_NAMES[] = { "FEATURE_TOON", "FEATURE_COOK_TORRANCE", "FEATURE_TEXTURES", "FEATURE_RIM" };
+
+} // namespace
+
+ShaderVariants::ShaderVariants(const char* vertexFile, const char* fragmentFile, Shader* fallback)
+	: vertexPath(vertexFile), fragmentPath(fragmentFile), fallback(fallback) {
+}
+
+Shader& ShaderVariants::Get(uint32_t features) {
+	auto it = variants.find(features);
+	if (it != variants.end()) return *it->second;
+
+	std::unique_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), Defines(features), true));
+	shader->fallback = fallback;
+	if (configure && shader->linked()) configure(*shader);
+	std::cout << "[Shader] variant 0x" << std::hex << features << std::dec << " of " << fragmentPath << std::endl;
+	created.push_back(shader.get());
+	return *(variants[features] = std::move(shader));
+}
+
+std::vector<Shader*> ShaderVariants::TakeNew() {
+	std::vector<Shader*> result;
+	result.swap(created);
+	return result;
+}
+
+std::string ShaderVariants::Defines(uint32_t features) {
+	std::string defines;
+	for (uint32_t bit = 0; bit < sizeof(FEATURE_NAMES) / sizeof(FEATURE_NAMES[0]); bit++) {
+		if (features & (1u << bit)) defines += std::string("#define ") + FEATURE_NAMES[bit] + "\n";
+	}
+	return defines;
+}
+
+void ShaderVariants::Delete() {
+	for (auto& variant : variants) variant.second->Delete();
+	variants.clear();
+	created.clear();
+}
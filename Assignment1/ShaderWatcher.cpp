@@ -0,0 +1,113 @@
+#include "ShaderWatcher.h"
+#include "Shader.h"
+#include <algorithm>
+#include <iostream>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+std::string directoryOf(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? "." : path.substr(0, slash);
+}
+
+// "dir/name" form used for comparing paths from both sources
+std::string normalized(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	return directoryOf(path) + "/" + (slash == std::string::npos ? path : path.substr(slash + 1));
+}
+
+std::time_t writeTime(const std::string& path) {
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+} // namespace
+
+ShaderWatcher::ShaderWatcher() {
+#ifdef __linux__
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd < 0) std::cerr << "[ShaderWatcher] inotify unavailable, polling file times" << std::endl;
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+	if (notifyFd >= 0) close(notifyFd);
+#endif
+}
+
+void ShaderWatcher::watchDirectory(const std::string& directory) {
+#ifdef __linux__
+	for (const auto& entry : directories) {
+		if (entry.second == directory) return;
+	}
+	// saves show up as a write, a rename onto the file or a new file
+	int wd = inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	if (wd >= 0) directories[wd] = directory;
+	else std::cerr << "[ShaderWatcher] can't watch " << directory << std::endl;
+#else
+	(void)directory;
+#endif
+}
+
+void ShaderWatcher::Watch(Shader& shader) {
+	if (std::find(shaders.begin(), shaders.end(), &shader) == shaders.end()) shaders.push_back(&shader);
+	for (const std::string& file : shader.sources()) {
+		if (notifyFd >= 0) watchDirectory(directoryOf(file));
+		else if (!writeTimes.count(file)) writeTimes[file] = writeTime(file);
+	}
+}
+
+std::vector<std::string> ShaderWatcher::changedFiles() {
+	std::vector<std::string> changed;
+#ifdef __linux__
+	if (notifyFd >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		for (;;) {
+			ssize_t length = read(notifyFd, buffer, sizeof(buffer));
+			if (length <= 0) break; // EAGAIN: nothing more queued
+			for (char* p = buffer; p < buffer + length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+				auto dir = directories.find(event->wd);
+				if (event->len > 0 && dir != directories.end()) changed.push_back(dir->second + "/" + event->name);
+				p += sizeof(inotify_event) + event->len;
+			}
+		}
+		return changed;
+	}
+#endif
+	// file times have a resolution of a second, a few checks per second are plenty
+	auto now = std::chrono::steady_clock::now();
+	if (now - lastCheck < std::chrono::milliseconds(250)) return changed;
+	lastCheck = now;
+	for (auto& entry : writeTimes) {
+		std::time_t time = writeTime(entry.first);
+		if (time != 0 && time != entry.second) {
+			entry.second = time;
+			changed.push_back(normalized(entry.first));
+		}
+	}
+	return changed;
+}
+
+std::vector<Shader*> ShaderWatcher::Poll() {
+	std::vector<Shader*> result;
+	std::vector<std::string> changed = changedFiles();
+	if (changed.empty()) return result;
+	for (std::string& file : changed) file = normalized(file);
+	for (Shader* shader : shaders) {
+		for (const std::string& source : shader->sources()) {
+			if (std::find(changed.begin(), changed.end(), normalized(source)) != changed.end()) {
+				result.push_back(shader);
+				break;
+			}
+		}
+	}
+	return result;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Stand-in while the real program is still compiling: flat grey lit from the camera
+
+in vec3 currPos;       // Receive the current position
+in vec3 normalWS;      // Receive world space normal
+
+out vec4 fragColor;
+
+#include "frame.glsl"
+
+void main() {
+    vec3 N = normalize(normalWS);
+    vec3 V = normalize(camPos - currPos);
+    float shade = ambient + 0.6 * max(dot(N, V), 0.0);
+    fragColor = vec4(vec3(0.6) * shade, 1.0);
+}
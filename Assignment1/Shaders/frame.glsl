@@ -0,0 +1,8 @@
+// Per-frame camera and light, shared by all programs (binding 0)
+layout(std140) uniform Frame {
+    mat4 camMatrix;  // proj * view
+    vec3 camPos;     // Position of the camera
+    float ambient;   // Ambient strength
+    vec4 lightColor; // Color of the light
+    vec3 lightPos;   // Position of the light
+};
@@ -1,25 +1,41 @@
 #version 330 core
 
+// Blinn-Phong, Toon and Cook-Torrance in one source. ShaderVariants picks the
+// variant with defines after #version, so none of these are runtime branches:
+//   FEATURE_TOON, FEATURE_COOK_TORRANCE  lighting model (neither: Blinn-Phong)
+//   FEATURE_TEXTURES                     sample diffuse0/specular0, else vertex color
+//   FEATURE_RIM                          toon rim lighting
+
 in vec3 currPos;       // Receive the current position
 in vec3 normalWS;		// Receive world space normal
 in vec3 vertexColor;   // Receive color from vertex shader
 in vec2 texCoord;      // Receive texture coordinates from vertex shader
+flat in int materialIndex; // Receive the material from vertex shader
 
 out vec4 fragColor;
 
-uniform bool useTextures = true; // Toggle texture usage
 uniform sampler2D diffuse0; // texture unit for diffuse
 uniform sampler2D specular0; // texture unit for specular
 uniform float uvScale = 1.0;
 
-uniform vec4 lightColor; // Gets the color of the light
-uniform vec3 lightPos;   // Gets the position of the light
-uniform vec3 camPos; // Gets the position of the camera
-
-uniform float ambient; // Ambient strength
-uniform float metallic; // Metalness factor
-uniform float roughness; // Surface roughness
-
+#include "frame.glsl"
+
+// Material parameters, indexed by materialIndex (binding 1)
+#define MAX_MATERIALS 16
+struct Material {
+    float specularStr; // Specular strength
+    float shininess;   // Shininess factor
+    float metallic;    // Metalness factor
+    float roughness;   // Surface roughness
+    int toonLevels;    // Number of toon shading bands
+    bool enableRim;    // Unused by the shader (FEATURE_RIM), kept for the block layout
+    float rimStrength; // Strength of Rim Lighting
+};
+layout(std140) uniform Materials {
+    Material materials[MAX_MATERIALS];
+};
+
+#ifdef FEATURE_COOK_TORRANCE
 const float PI = 3.14159265359;
 
 // GGX Distribution that controls shape of highlights
@@ -48,41 +64,52 @@ float GeometricShadow(float NdotV, float NdotL, float roughness) {
     float g2 = NdotL / (NdotL * (1.0 - k) + k); // shadowing from light
     return g1 * g2; // combined shadowing
 }
+#endif
 
 void main() {
+    Material mat = materials[materialIndex];
+
     // Lighting Vectors
     vec3 N = normalize(normalWS);
     vec3 L = normalize(lightPos - currPos);
     vec3 V = normalize(camPos - currPos);
     vec3 H = normalize(L + V);  // Halfway vector
 
+    // Attenuation
+    float distance = length(lightPos - currPos);
+    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
+
+    // Sample textures with fallback
+#ifdef FEATURE_TEXTURES
+    vec4 baseColor = texture(diffuse0, texCoord * uvScale);
+    float specularMap = texture(specular0, texCoord * uvScale).r;
+#else
+    vec4 baseColor = vec4(vertexColor, 1.0);
+    float specularMap = 0.5;
+#endif
+
+#if defined(FEATURE_COOK_TORRANCE)
     // Dot Products that are reused for D, F, G
     float NdotL = max(dot(N, L), 0.0); // how much surface faces light
     float NdotV = max(dot(N, V), 0.0); // how much surface faces camera
     float NdotH = max(dot(N, H), 0.0); // specular alignment
     float VdotH = max(dot(V, H), 0.0); // fresnel calculation
 
-    // Attenuation
-    float distance = length(lightPos - currPos);
-    float attenuation = 1.0 / (1.0 + 0.09 * distance + 0.032 * distance * distance);
-
-    // Sample textures with fallback
-    vec3 albedo = useTextures ? texture(diffuse0, texCoord * uvScale).rgb : vertexColor;
-    float roughnessMap = useTextures ? texture(specular0, texCoord * uvScale).r : 0.5;
-    float finalRoughness = roughness * roughnessMap; // combine uniform and texture
+    vec3 albedo = baseColor.rgb;
+    float finalRoughness = mat.roughness * specularMap; // combine uniform and texture
     finalRoughness = clamp(finalRoughness, 0.04, 1.0); // avoid 0 roughness
 
     // Calculate Base Reflectivity F0 based on metalness
-    float F0 = mix(0.04, 1.0, metallic); // non-metals reflect ~4%, metals reflect albedo
+    float F0 = mix(0.04, 1.0, mat.metallic); // non-metals reflect ~4%, metals reflect albedo
 
     // Cook-Torrance BRDF
-    float D = GGXDistribution(NdotH, finalRoughness); // no. of microfacets 
+    float D = GGXDistribution(NdotH, finalRoughness); // no. of microfacets
     float F = FresnelReflection(VdotH, F0); // reflectivity at angle
     float G = GeometricShadow(NdotV, NdotL, finalRoughness); // shadowing/masking
     float specular = (D * F * G) / max(4.0 * NdotV * NdotL, 0.001);
-    
+
     // Diffuse and Ambience terms
-    float kD = (1.0 - F) * (1.0 - metallic); // diffuse scattering
+    float kD = (1.0 - F) * (1.0 - mat.metallic); // diffuse scattering
     vec3 diffuse = (albedo / PI) * kD; // Lambertian diffuse
     vec3 ambientTerm = ambient * albedo; // Ambient term
 
@@ -90,4 +117,31 @@ void main() {
     vec3 result = ambientTerm + ((diffuse + specular) * lightColor.rgb * NdotL * attenuation);
 
     fragColor = vec4(result, 1.0);
+#else
+    float diffuse = max(dot(N, L), 0.0);
+    float spec = pow(max(dot(N, H), 0.0), mat.shininess);
+    float rim = 0.0;
+
+#ifdef FEATURE_TOON
+    // Diffuse and specular quantized into discrete bands
+    float levels = float(mat.toonLevels);
+    diffuse = floor(diffuse * levels) / levels;
+    if (spec > 0.01) spec = floor(spec * levels) / levels;
+
+#ifdef FEATURE_RIM
+    float rimFactor = 1.0 - max(dot(N, V), 0.0); // Edges perpendicular to camera
+    float rimIntensity = pow(rimFactor, 3); // sharp falloff
+    if (rimIntensity > 0.5) rim = mat.rimStrength; // threshold application
+#endif
+#endif
+
+    float specular = mat.specularStr * spec;
+
+    // Combine
+    vec3 result = (baseColor.rgb * (ambient + diffuse) + specularMap * specular + rim) * lightColor.rgb;
+
+    result *= attenuation;  // Apply distance falloff
+
+    fragColor = vec4(result, baseColor.a);
+#endif
 }
@@ -1,39 +1,72 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPos;     // Vertex position
-layout (location = 1) in vec3 aNormal;  // Normals
+layout (location = 0) in vec3 aPos;     // Vertex position (normalized 16-bit when packed)
+layout (location = 1) in vec3 aNormal;  // Normals (octahedral xy when packed)
 layout (location = 2) in vec3 aColor;   // Vertex color
 layout (location = 3) in vec2 aTex;     // Texture Coordinates
+layout (location = 4) in mat4 aInstanceModel; // Per-instance model matrix (locations 4-7)
+layout (location = 8) in int aMaterial;       // Per-instance material index
+layout (location = 9) in vec3 aPosScale;      // Per-draw dequantization (batched draws)
+layout (location = 10) in vec3 aPosOffset;
+layout (location = 11) in mat3 aInstanceNormal; // Per-instance normal matrix (locations 11-13)
 
 out vec3 currPos;      // Pass the current position
 out vec3 normalWS;     // Pass normal to fragment shader
 out vec3 vertexColor;  // Pass color to fragment shader
 out vec2 texCoord;     // Pass texture coordinates to fragment shader
+flat out int materialIndex; // Pass the instance's material to fragment shader
 
-// Imports the camera matrix from the main function
-uniform mat4 camMatrix;  // proj * view
+#include "frame.glsl"
 
 // Imports the model matrix from the main function
 uniform mat4 model;
+// Inverse transpose of model's 3x3, computed on the CPU (Shader::setModelMatrix)
+uniform mat3 normalMatrix = mat3(1.0);
+// Instanced draws: world = aInstanceModel * model
+uniform bool instanced = false;
+// Material used by non-instanced draws
+uniform int material = 0;
+// Multi-draw batches: transform, material and dequantization all come per draw
+// (the instance attributes, selected by baseInstance)
+uniform bool batched = false;
 
+// Packed vertices: position = aPos * posScale + posOffset (the mesh AABB)
+uniform vec3 posScale = vec3(1.0);
+uniform vec3 posOffset = vec3(0.0);
+// Packed vertices: normals are octahedral encoded
+uniform bool octNormals = false;
+
+// Unfolds an octahedral encoded normal
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
-    // local values
-    vec4 localPos = vec4(aPos, 1.0f);
-    vec3 localNormal = aNormal;
+    // local values (dequantized if the mesh is packed)
+    vec3 scale = batched ? aPosScale : posScale;
+    vec3 offset = batched ? aPosOffset : posOffset;
+    vec4 localPos = vec4(aPos * scale + offset, 1.0f);
+    vec3 localNormal = octNormals ? octDecode(aNormal.xy) : aNormal;
 
     // transform into world space 
-    vec4 worldPos = model * localPos;
+    bool perInstance = instanced || batched;
+    mat4 world = perInstance ? aInstanceModel * model : model;
+    vec4 worldPos = world * localPos;
     currPos = worldPos.xyz;
 
     // assign the normal from model space to world space
-    mat3 normalMatrix = mat3(transpose(inverse(model)));
-    normalWS = normalize(normalMatrix * localNormal);
+    mat3 worldNormal = perInstance ? aInstanceNormal * normalMatrix : normalMatrix;
+    normalWS = normalize(worldNormal * localNormal);
 
     // pass color and tex coords
     vertexColor = aColor;
     texCoord = aTex;
+    materialIndex = perInstance ? aMaterial : material;
 
     // final clip-space position
     gl_Position = camMatrix * worldPos;
-}
\ No newline at end of file
+}
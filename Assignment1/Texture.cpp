@@ -1,5 +1,7 @@
 #include"Texture.h"
 #include"Shader.h"
+#include"TextureCompressor.h"
+#include"GLState.h"
 #include <iostream>
 #include<stb/stb_image.h>
 
@@ -8,50 +10,15 @@ Texture::Texture(const char* image, const char* texType, GLuint texSlot, GLenum
 	type = texType;
 	// Remember the slot
 	slot = texSlot;
+	ID = 0;
 
-	// Stores the width, height, and the number of color channels of the image
-	int widthImg, heightImg, numColCh;
-	// Flips the image so it appears right side up
-	stbi_set_flip_vertically_on_load(true);
-	// Reads the image from a file and stores it in bytes
-	unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
-	if (!bytes) {
+	// Reads the image from a file
+	ImageData decoded;
+	if (!Decode(image, decoded)) {
 		std::cerr << "Failed to load texture: " << image << std::endl;
-		ID = 0;
 		return;
 	}
-
-	// Auto-pick source/internal format based on channels
-	GLenum format = GL_RGBA;
-	if (numColCh == 3)
-		format = GL_RGB;
-	else if (numColCh == 1)
-		format = GL_RED;
-
-	// Generates an OpenGL texture object
-	glGenTextures(1, &ID);
-	// Assigns the texture to a Texture Unit
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
-
-	// Configures the type of algorithm that is used to make the image smaller or bigger
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	// Configures the way the texture repeats
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	// Assigns the image to the OpenGL Texture object
-	glTexImage2D(GL_TEXTURE_2D, 0, format, widthImg, heightImg, 0, format, pixelType, bytes);
-	// Generates MipMaps
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	// Deletes the image data as it is already in the OpenGL Texture object
-	stbi_image_free(bytes);
-
-	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
-	glBindTexture(GL_TEXTURE_2D, 0);
+	upload(decoded, pixelType, GL_NEAREST);
 }
 
 // Constructor for embedded textures loaded from memory
@@ -60,70 +27,156 @@ Texture::Texture(const unsigned char* data, size_t size, const char* texType, GL
 	type = texType;
 	// Remember the slot
 	slot = texSlot;
+	ID = 0;
 
-	// Stores the width, height, and the number of color channels of the image
-	int widthImg, heightImg, numColCh;
-	// Flips the image so it appears right side up
-	stbi_set_flip_vertically_on_load(true);
 	// Reads the image loaded from memory
-	unsigned char* bytes = stbi_load_from_memory(data, static_cast<int>(size), &widthImg, &heightImg, &numColCh, 0);
-	if (!bytes) {
+	ImageData decoded;
+	if (!Decode(data, size, decoded)) {
 		std::cerr << "Failed to load embedded texture: " <<  std::endl;
-		ID = 0;
 		return;
 	}
+	upload(decoded, pixelType, GL_LINEAR);
+}
 
+// Constructor for images decoded ahead of time
+Texture::Texture(const ImageData& image, const char* texType, GLuint texSlot, GLenum pixelType, GLenum filter) {
+	type = texType;
+	slot = texSlot;
+	ID = 0;
+	if (!image.valid()) return;
+	upload(image, pixelType, filter);
+}
+
+// Copies stb's output into an ImageData
+static bool takeImage(unsigned char* bytes, int widthImg, int heightImg, int numColCh, ImageData& out) {
+	if (!bytes) return false;
+	out.width = widthImg;
+	out.height = heightImg;
+	out.channels = numColCh;
+	out.pixels.assign(bytes, bytes + (size_t)widthImg * heightImg * numColCh);
+	// Deletes the stb copy as it is now in the ImageData
+	stbi_image_free(bytes);
+	return true;
+}
+
+bool Texture::Decode(const char* image, ImageData& out) {
+	// Stores the width, height, and the number of color channels of the image
+	int widthImg, heightImg, numColCh;
+	// Flips the image so it appears right side up (per thread, decoders run in parallel)
+	stbi_set_flip_vertically_on_load_thread(true);
+	// Reads the image from a file and stores it in bytes
+	unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
+	return takeImage(bytes, widthImg, heightImg, numColCh, out);
+}
+
+bool Texture::Decode(const unsigned char* data, size_t size, ImageData& out) {
+	// Stores the width, height, and the number of color channels of the image
+	int widthImg, heightImg, numColCh;
+	// Flips the image so it appears right side up (per thread, decoders run in parallel)
+	stbi_set_flip_vertically_on_load_thread(true);
+	// Reads the image loaded from memory
+	unsigned char* bytes = stbi_load_from_memory(data, static_cast<int>(size), &widthImg, &heightImg, &numColCh, 0);
+	return takeImage(bytes, widthImg, heightImg, numColCh, out);
+}
+
+// Constructor for a texture whose pixels arrive later (TextureStreamer)
+Texture::Texture(const char* texType, GLuint texSlot) {
+	type = texType;
+	slot = texSlot;
+
+	// white so untextured-looking meshes don't flash black while streaming
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &ID);
+	GLState::BindTexture(slot, ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	GLState::BindTexture(slot, 0);
+}
+
+void Texture::upload(const ImageData& image, GLenum pixelType, GLenum filter) {
+	// Generates an OpenGL texture object
+	glGenTextures(1, &ID);
+	SetImage(image.width, image.height, image.channels, pixelType, image.pixels.data(), filter);
+}
+
+void Texture::SetImage(int width, int height, int channels, GLenum pixelType, const void* data, GLenum filter, GLuint unpackBuffer) {
 	// Auto-pick source/internal format based on channels
 	GLenum format = GL_RGBA;
-	if (numColCh == 3)
+	if (channels == 3)
 		format = GL_RGB;
-	else if (numColCh == 1)
+	else if (channels == 1)
 		format = GL_RED;
 
-	// Generates an OpenGL texture object
-	glGenTextures(1, &ID);
 	// Assigns the texture to a Texture Unit
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	GLState::BindTexture(slot, ID);
 
 	// Configures the type of algorithm that is used to make the image smaller or bigger
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLenum minFilter = (filter == GL_NEAREST) ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
 
 	// Configures the way the texture repeats
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	// Assigns the image to the OpenGL Texture object
-	glTexImage2D(GL_TEXTURE_2D, 0, format, widthImg, heightImg, 0, format, pixelType, bytes);
+	// rows of 1/3-channel images aren't always 4-byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	// Allocates the storage with no PBO bound (a null pointer would otherwise
+	// read a whole image from offset 0), then fills it from client memory or the PBO
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, pixelType, nullptr);
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, pixelType, data);
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	// Generates MipMaps
 	glGenerateMipmap(GL_TEXTURE_2D);
 
-	// Deletes the image data as it is already in the OpenGL Texture object
-	stbi_image_free(bytes);
-
 	// Unbinds the OpenGL Texture object so that it can't accidentally be modified
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(slot, 0);
+}
+
+void Texture::SetCompressed(const CompressedImage& image, GLenum filter) {
+	GLState::BindTexture(slot, ID);
+
+	GLenum minFilter = (filter == GL_NEAREST) ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// Mips come with the image, the driver can't generate them for compressed data
+	GLenum internalFormat = TextureCompressor::InternalFormat(image.format);
+	int width = image.width;
+	int height = image.height;
+	for (size_t level = 0; level < image.levels.size(); level++) {
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, internalFormat, width, height, 0,
+			(GLsizei)image.levels[level].size(), image.levels[level].data());
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+
+	GLState::BindTexture(slot, 0);
 }
 
 void Texture::texUnit(Shader& shader, const char* uniform, GLuint unit) {
-	// Gets the location of the uniform
-	GLuint texUni = glGetUniformLocation(shader.ID, uniform);
-	// Shader needs to be activated before changing the value of a uniform
+	// Shader needs to be activated before changing the value of a uniform (no-op if it already is)
 	shader.Activate();
-	// Sets the value of the uniform
-	glUniform1i(texUni, unit);
+	// Sets the value of the uniform (location is cached by the shader)
+	shader.setInt(uniform, unit);
 }
 
 void Texture::Bind() {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, ID);
+	GLState::BindTexture(slot, ID);
 }
 
 void Texture::Unbind() {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(slot, 0);
 }
 
 void Texture::Delete() {
+	GLState::ForgetTexture(ID);
 	glDeleteTextures(1, &ID);
 }
\ No newline at end of file
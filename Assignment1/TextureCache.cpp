@@ -0,0 +1,53 @@
+#include "TextureCache.h"
+
+TextureCache& TextureCache::Instance() {
+	static TextureCache cache;
+	return cache;
+}
+
+std::string TextureCache::KeyForFile(const std::string& path, const char* texType) {
+	return path + "#" + texType;
+}
+
+std::string TextureCache::KeyForEmbedded(const std::string& modelPath, int index, const char* texType) {
+	// same "*N" syntax Assimp uses for embedded textures
+	return modelPath + "*" + std::to_string(index) + "#" + texType;
+}
+
+std::shared_ptr<Texture> TextureCache::Find(const std::string& key) {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = textures.find(key);
+	if (it != textures.end()) {
+		if (std::shared_ptr<Texture> texture = it->second.lock()) {
+			hits++;
+			return texture;
+		}
+		textures.erase(it);
+	}
+	misses++;
+	return nullptr;
+}
+
+bool TextureCache::Contains(const std::string& key) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = textures.find(key);
+	return it != textures.end() && !it->second.expired();
+}
+
+void TextureCache::Store(const std::string& key, const std::shared_ptr<Texture>& texture) {
+	std::lock_guard<std::mutex> lock(mutex);
+	textures[key] = texture;
+}
+
+void TextureCache::Prune() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto it = textures.begin(); it != textures.end();) {
+		if (it->second.expired()) it = textures.erase(it);
+		else ++it;
+	}
+}
+
+size_t TextureCache::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return textures.size();
+}
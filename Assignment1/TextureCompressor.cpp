@@ -0,0 +1,489 @@
+#include "TextureCompressor.h"
+#include "ThreadPool.h"
+#include "GLExt.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RTR_SSE2 1
+#endif
+
+// -------------------- Format info --------------------
+
+BCFormat TextureCompressor::FormatForRole(const char* texType) {
+	std::string type = texType;
+	if (type == "normal") return BCFormat::BC5;
+	if (type == "specular" || type == "roughness" || type == "metallic") return BCFormat::BC4;
+	// colour: BC7 where available, BC1 is the universal fallback
+	return Supported(BCFormat::BC7) ? BCFormat::BC7 : BCFormat::BC1;
+}
+
+bool TextureCompressor::Supported(BCFormat format) {
+	switch (format) {
+	case BCFormat::BC1: return GLExt::hasS3TC;
+	case BCFormat::BC7: return GLExt::hasBPTC;
+	default: return true; // RGTC is core since GL 3.0
+	}
+}
+
+GLenum TextureCompressor::InternalFormat(BCFormat format) {
+	switch (format) {
+	case BCFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BCFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+	case BCFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+	default: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+GLenum TextureCompressor::BaseFormat(BCFormat format) {
+	switch (format) {
+	case BCFormat::BC1: return GL_RGB;
+	case BCFormat::BC4: return GL_RED;
+	case BCFormat::BC5: return GL_RG;
+	default: return GL_RGBA;
+	}
+}
+
+size_t TextureCompressor::BlockBytes(BCFormat format) {
+	return (format == BCFormat::BC1 || format == BCFormat::BC4) ? 8 : 16;
+}
+
+size_t TextureCompressor::LevelSize(BCFormat format, int width, int height) {
+	size_t bw = (size_t)std::max(1, (width + 3) / 4);
+	size_t bh = (size_t)std::max(1, (height + 3) / 4);
+	return bw * bh * BlockBytes(format);
+}
+
+// -------------------- Helpers --------------------
+
+namespace {
+
+// Expands any channel count to RGBA8
+std::vector<unsigned char> toRGBA(const ImageData& image) {
+	size_t count = (size_t)image.width * image.height;
+	std::vector<unsigned char> rgba(count * 4);
+	const unsigned char* src = image.pixels.data();
+	for (size_t i = 0; i < count; ++i) {
+		unsigned char* d = &rgba[i * 4];
+		const unsigned char* s = src + i * image.channels;
+		switch (image.channels) {
+		case 1: d[0] = d[1] = d[2] = s[0]; d[3] = 255; break;
+		case 2: d[0] = d[1] = d[2] = s[0]; d[3] = s[1]; break;
+		case 3: d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 255; break;
+		default: std::memcpy(d, s, 4); break;
+		}
+	}
+	return rgba;
+}
+
+// 2x2 box filter, odd edges are clamped
+std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, int w, int h, int& outW, int& outH) {
+	outW = std::max(1, w / 2);
+	outH = std::max(1, h / 2);
+	std::vector<unsigned char> dst((size_t)outW * outH * 4);
+	for (int y = 0; y < outH; ++y) {
+		int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+		for (int x = 0; x < outW; ++x) {
+			int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+			for (int c = 0; c < 4; ++c) {
+				int sum = src[((size_t)y0 * w + x0) * 4 + c] + src[((size_t)y0 * w + x1) * 4 + c]
+					+ src[((size_t)y1 * w + x0) * 4 + c] + src[((size_t)y1 * w + x1) * 4 + c];
+				dst[((size_t)y * outW + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+	return dst;
+}
+
+// Copies a 4x4 block, replicating edge pixels for partial blocks
+void fetchBlock(const std::vector<unsigned char>& rgba, int w, int h, int bx, int by, unsigned char* block) {
+	for (int y = 0; y < 4; ++y) {
+		int sy = std::min(by * 4 + y, h - 1);
+		for (int x = 0; x < 4; ++x) {
+			int sx = std::min(bx * 4 + x, w - 1);
+			std::memcpy(block + (y * 4 + x) * 4, &rgba[((size_t)sy * w + sx) * 4], 4);
+		}
+	}
+}
+
+// Per-channel min/max over the 16 pixels of a block
+void blockBounds(const unsigned char* rgba, unsigned char* mn, unsigned char* mx) {
+#ifdef RTR_SSE2
+	__m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba));
+	__m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + 16));
+	__m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + 32));
+	__m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + 48));
+	__m128i lo = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+	__m128i hi = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+	// fold the 4 pixels in each register down to one
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 8));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 8));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+	int l = _mm_cvtsi128_si32(lo), u = _mm_cvtsi128_si32(hi);
+	std::memcpy(mn, &l, 4);
+	std::memcpy(mx, &u, 4);
+#else
+	for (int c = 0; c < 4; ++c) { mn[c] = 255; mx[c] = 0; }
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 4; ++c) {
+			mn[c] = std::min(mn[c], rgba[i * 4 + c]);
+			mx[c] = std::max(mx[c], rgba[i * 4 + c]);
+		}
+	}
+#endif
+}
+
+// min/max of 16 bytes
+void channelBounds(const unsigned char* v, unsigned char& mn, unsigned char& mx) {
+#ifdef RTR_SSE2
+	__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v));
+	__m128i lo = _mm_min_epu8(x, _mm_srli_si128(x, 8));
+	__m128i hi = _mm_max_epu8(x, _mm_srli_si128(x, 8));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 4));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 4));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 2));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 2));
+	lo = _mm_min_epu8(lo, _mm_srli_si128(lo, 1));
+	hi = _mm_max_epu8(hi, _mm_srli_si128(hi, 1));
+	mn = (unsigned char)(_mm_cvtsi128_si32(lo) & 0xFF);
+	mx = (unsigned char)(_mm_cvtsi128_si32(hi) & 0xFF);
+#else
+	mn = 255; mx = 0;
+	for (int i = 0; i < 16; ++i) { mn = std::min(mn, v[i]); mx = std::max(mx, v[i]); }
+#endif
+}
+
+uint16_t pack565(int r, int g, int b) {
+	return (uint16_t)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+void unpack565(uint16_t c, int* rgb) {
+	int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// 128-bit little-endian bit writer for BC7
+struct BitWriter {
+	unsigned char* out;
+	int pos = 0;
+	explicit BitWriter(unsigned char* o) : out(o) { std::memset(out, 0, 16); }
+	void put(unsigned int value, int bits) {
+		for (int i = 0; i < bits; ++i, ++pos) {
+			if (value & (1u << i)) out[pos >> 3] |= (unsigned char)(1u << (pos & 7));
+		}
+	}
+};
+
+const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Quantizes an RGBA endpoint to 7 bits + shared p-bit, returns the p-bit
+int quantizeEndpoint7p(const float* e, int* q) {
+	int bestP = 0;
+	float bestErr = 1e30f;
+	int tmp[4];
+	for (int p = 0; p < 2; ++p) {
+		float err = 0.0f;
+		for (int c = 0; c < 4; ++c) {
+			int v = (int)std::lround((e[c] - p) * 0.5f);
+			tmp[c] = std::min(127, std::max(0, v));
+			float d = (float)((tmp[c] << 1) | p) - e[c];
+			err += d * d;
+		}
+		if (err < bestErr) {
+			bestErr = err;
+			bestP = p;
+			std::memcpy(q, tmp, sizeof(tmp));
+		}
+	}
+	return bestP;
+}
+
+// Picks the best of 16 palette entries per pixel, returns total error
+int bc7Indices(const unsigned char* rgba, const int* q0, int p0, const int* q1, int p1, int* indices) {
+	int palette[16][4];
+	for (int c = 0; c < 4; ++c) {
+		int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+		for (int i = 0; i < 16; ++i) {
+			palette[i][c] = ((64 - BC7_WEIGHTS4[i]) * a + BC7_WEIGHTS4[i] * b + 32) >> 6;
+		}
+	}
+	int total = 0;
+	for (int p = 0; p < 16; ++p) {
+		int best = 0, bestErr = 1 << 30;
+		for (int i = 0; i < 16; ++i) {
+			int err = 0;
+			for (int c = 0; c < 4; ++c) {
+				int d = palette[i][c] - rgba[p * 4 + c];
+				err += d * d;
+			}
+			if (err < bestErr) { bestErr = err; best = i; }
+		}
+		indices[p] = best;
+		total += bestErr;
+	}
+	return total;
+}
+
+} // namespace
+
+// -------------------- Block encoders --------------------
+
+void TextureCompressor::EncodeBC1(const unsigned char* rgba, unsigned char* out) {
+	unsigned char mn[4], mx[4];
+	blockBounds(rgba, mn, mx);
+
+	// pick the bounding box diagonal that follows the colour trend
+	int center[3] = { (mn[0] + mx[0]) / 2, (mn[1] + mx[1]) / 2, (mn[2] + mx[2]) / 2 };
+	int covRG = 0, covRB = 0, covGB = 0;
+	for (int i = 0; i < 16; ++i) {
+		int r = rgba[i * 4] - center[0], g = rgba[i * 4 + 1] - center[1], b = rgba[i * 4 + 2] - center[2];
+		covRG += r * g; covRB += r * b; covGB += g * b;
+	}
+	int hi[3] = { mx[0], mx[1], mx[2] }, lo[3] = { mn[0], mn[1], mn[2] };
+	bool redFlat = mx[0] == mn[0];
+	if (!redFlat && covRG < 0) std::swap(hi[1], lo[1]);
+	if ((redFlat ? covGB : covRB) < 0) std::swap(hi[2], lo[2]);
+
+	// inset by 1/16 of the range to reduce error at the extremes
+	for (int c = 0; c < 3; ++c) {
+		int inset = (hi[c] - lo[c]) / 16;
+		hi[c] -= inset;
+		lo[c] += inset;
+	}
+
+	uint16_t c0 = pack565(hi[0], hi[1], hi[2]);
+	uint16_t c1 = pack565(lo[0], lo[1], lo[2]);
+	// 4-colour mode needs c0 > c1
+	if (c0 < c1) std::swap(c0, c1);
+
+	uint32_t indices = 0;
+	if (c0 != c1) {
+		int palette[4][3];
+		unpack565(c0, palette[0]);
+		unpack565(c1, palette[1]);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; ++i) {
+			int best = 0, bestErr = 1 << 30;
+			for (int j = 0; j < 4; ++j) {
+				int dr = palette[j][0] - rgba[i * 4], dg = palette[j][1] - rgba[i * 4 + 1], db = palette[j][2] - rgba[i * 4 + 2];
+				int err = dr * dr + dg * dg + db * db;
+				if (err < bestErr) { bestErr = err; best = j; }
+			}
+			indices |= (uint32_t)best << (i * 2);
+		}
+	}
+
+	out[0] = (unsigned char)(c0 & 0xFF); out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xFF); out[3] = (unsigned char)(c1 >> 8);
+	std::memcpy(out + 4, &indices, 4);
+}
+
+void TextureCompressor::EncodeBC4(const unsigned char* rgba, int channel, unsigned char* out) {
+	unsigned char v[16];
+	for (int i = 0; i < 16; ++i) v[i] = rgba[i * 4 + channel];
+	unsigned char mn, mx;
+	channelBounds(v, mn, mx);
+
+	// 8-value mode: red0 = max, red1 = min, six interpolated values between
+	out[0] = mx;
+	out[1] = mn;
+	uint64_t bits = 0;
+	int range = mx - mn;
+	if (range > 0) {
+		for (int i = 0; i < 16; ++i) {
+			// position along min..max in sevenths, rounded
+			int p = ((v[i] - mn) * 14 + range) / (2 * range);
+			int code = (p == 7) ? 0 : (p == 0) ? 1 : 8 - p;
+			bits |= (uint64_t)code << (i * 3);
+		}
+	}
+	for (int i = 0; i < 6; ++i) out[2 + i] = (unsigned char)(bits >> (i * 8));
+}
+
+void TextureCompressor::EncodeBC5(const unsigned char* rgba, unsigned char* out) {
+	EncodeBC4(rgba, 0, out);
+	EncodeBC4(rgba, 1, out + 8);
+}
+
+void TextureCompressor::EncodeBC7(const unsigned char* rgba, unsigned char* out) {
+	// Mode 6: one subset, RGBA 7.7.7.7 endpoints + unique p-bits, 4-bit indices
+
+	// principal axis through the block (power iteration on the covariance)
+	float mean[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 4; ++c) mean[c] += rgba[i * 4 + c];
+	for (int c = 0; c < 4; ++c) mean[c] /= 16.0f;
+
+	float cov[4][4] = {};
+	for (int i = 0; i < 16; ++i) {
+		float d[4];
+		for (int c = 0; c < 4; ++c) d[c] = rgba[i * 4 + c] - mean[c];
+		for (int a = 0; a < 4; ++a)
+			for (int b = 0; b < 4; ++b) cov[a][b] += d[a] * d[b];
+	}
+	unsigned char mn[4], mx[4];
+	blockBounds(rgba, mn, mx);
+	float axis[4];
+	for (int c = 0; c < 4; ++c) axis[c] = (float)(mx[c] - mn[c]) + 1e-3f;
+	for (int it = 0; it < 4; ++it) {
+		float next[4] = {};
+		for (int a = 0; a < 4; ++a)
+			for (int b = 0; b < 4; ++b) next[a] += cov[a][b] * axis[b];
+		float len = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (len < 1e-6f) break;
+		for (int c = 0; c < 4; ++c) axis[c] = next[c] / len;
+	}
+	float axisLen2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+
+	// endpoints = extreme projections onto the axis
+	float tMin = 1e30f, tMax = -1e30f;
+	for (int i = 0; i < 16; ++i) {
+		float t = 0.0f;
+		for (int c = 0; c < 4; ++c) t += (rgba[i * 4 + c] - mean[c]) * axis[c];
+		t /= axisLen2;
+		tMin = std::min(tMin, t);
+		tMax = std::max(tMax, t);
+	}
+	float e0[4], e1[4];
+	for (int c = 0; c < 4; ++c) {
+		e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + tMin * axis[c]));
+		e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + tMax * axis[c]));
+	}
+
+	int q0[4], q1[4], indices[16];
+	int p0 = quantizeEndpoint7p(e0, q0);
+	int p1 = quantizeEndpoint7p(e1, q1);
+	int err = bc7Indices(rgba, q0, p0, q1, p1, indices);
+
+	// one least-squares refit of the endpoints for the chosen indices
+	if (err > 0) {
+		float aa = 0, bb = 0, ab = 0, ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; ++i) {
+			float w = BC7_WEIGHTS4[indices[i]] / 64.0f;
+			float a = 1.0f - w;
+			aa += a * a; bb += w * w; ab += a * w;
+			for (int c = 0; c < 4; ++c) { ax[c] += a * rgba[i * 4 + c]; bx[c] += w * rgba[i * 4 + c]; }
+		}
+		float det = aa * bb - ab * ab;
+		if (std::fabs(det) > 1e-6f) {
+			float r0[4], r1[4];
+			for (int c = 0; c < 4; ++c) {
+				r0[c] = std::min(255.0f, std::max(0.0f, (bb * ax[c] - ab * bx[c]) / det));
+				r1[c] = std::min(255.0f, std::max(0.0f, (aa * bx[c] - ab * ax[c]) / det));
+			}
+			int rq0[4], rq1[4], rIndices[16];
+			int rp0 = quantizeEndpoint7p(r0, rq0);
+			int rp1 = quantizeEndpoint7p(r1, rq1);
+			int rErr = bc7Indices(rgba, rq0, rp0, rq1, rp1, rIndices);
+			if (rErr < err) {
+				std::memcpy(q0, rq0, sizeof(q0)); std::memcpy(q1, rq1, sizeof(q1));
+				std::memcpy(indices, rIndices, sizeof(indices));
+				p0 = rp0; p1 = rp1;
+			}
+		}
+	}
+
+	// the anchor index is stored with 3 bits, so its top bit must be 0
+	if (indices[0] & 8) {
+		std::swap(q0, q1);
+		std::swap(p0, p1);
+		for (int i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+	}
+
+	BitWriter w(out);
+	w.put(1u << 6, 7); // mode 6
+	for (int c = 0; c < 4; ++c) {
+		w.put((unsigned int)q0[c], 7);
+		w.put((unsigned int)q1[c], 7);
+	}
+	w.put((unsigned int)p0, 1);
+	w.put((unsigned int)p1, 1);
+	w.put((unsigned int)indices[0], 3);
+	for (int i = 1; i < 16; ++i) w.put((unsigned int)indices[i], 4);
+}
+
+// -------------------- Images --------------------
+
+CompressedImage TextureCompressor::Compress(const ImageData& image, BCFormat format) {
+	CompressedImage result;
+	if (!image.valid()) return result;
+	result.format = format;
+	result.width = image.width;
+	result.height = image.height;
+
+	std::vector<unsigned char> level = toRGBA(image);
+	int w = image.width, h = image.height;
+	size_t blockBytes = BlockBytes(format);
+
+	for (;;) {
+		int blocksX = std::max(1, (w + 3) / 4);
+		int blocksY = std::max(1, (h + 3) / 4);
+		std::vector<unsigned char> out((size_t)blocksX * blocksY * blockBytes);
+
+		// one block row per job
+		ThreadPool::Shared().ParallelFor((size_t)blocksY, [&](size_t by) {
+			unsigned char block[64];
+			for (int bx = 0; bx < blocksX; ++bx) {
+				fetchBlock(level, w, h, bx, (int)by, block);
+				unsigned char* dst = &out[((size_t)by * blocksX + bx) * blockBytes];
+				switch (format) {
+				case BCFormat::BC1: EncodeBC1(block, dst); break;
+				case BCFormat::BC4: EncodeBC4(block, 0, dst); break;
+				case BCFormat::BC5: EncodeBC5(block, dst); break;
+				case BCFormat::BC7: EncodeBC7(block, dst); break;
+				}
+			}
+		});
+		result.levels.push_back(std::move(out));
+
+		if (w == 1 && h == 1) break;
+		int nw, nh;
+		level = downsample(level, w, h, nw, nh);
+		w = nw;
+		h = nh;
+	}
+	return result;
+}
+
+void TextureCompressor::Benchmark(int size) {
+	// gradient + noise, roughly like a real albedo map
+	ImageData image;
+	image.width = size;
+	image.height = size;
+	image.channels = 4;
+	image.pixels.resize((size_t)size * size * 4);
+	std::srand(1234);
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			unsigned char* p = &image.pixels[((size_t)y * size + x) * 4];
+			int n = std::rand() % 32;
+			p[0] = (unsigned char)((x * 255 / size + n) & 0xFF);
+			p[1] = (unsigned char)((y * 255 / size + n) & 0xFF);
+			p[2] = (unsigned char)(((x + y) * 127 / size) & 0xFF);
+			p[3] = 255;
+		}
+	}
+
+	const BCFormat formats[] = { BCFormat::BC1, BCFormat::BC4, BCFormat::BC5, BCFormat::BC7 };
+	for (BCFormat format : formats) {
+		auto start = std::chrono::steady_clock::now();
+		CompressedImage c = Compress(image, format);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		double mpix = (double)size * size * 4.0 / 3.0 / 1e6; // including mips
+		std::cout << "[TextureCompressor] BC" << (int)format << " " << size << "x" << size
+			<< ": " << ms << " ms, " << (mpix / (ms / 1000.0)) << " MPix/s on "
+			<< ThreadPool::Shared().size() + 1 << " threads, " << c.levels.size() << " mips\n";
+	}
+}
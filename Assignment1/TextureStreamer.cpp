@@ -0,0 +1,274 @@
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include "GLExt.h"
+#include "GLState.h"
+#include "KtxCache.h"
+#include "FileUtils.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+// One texture on its way from disk/memory to the GPU
+struct TextureStreamer::Job {
+	std::weak_ptr<Texture> target;
+	std::string path;
+	std::vector<unsigned char> bytes;
+	GLenum filter = GL_LINEAR;
+	ImageData image;
+	// block compression, decided on the render thread
+	bool compress = false;
+	BCFormat format = BCFormat::BC1;
+	CompressedImage compressed;
+};
+
+TextureStreamer& TextureStreamer::Instance() {
+	static TextureStreamer streamer;
+	return streamer;
+}
+
+TextureStreamer::~TextureStreamer() {
+	// GL may already be gone at exit, Shutdown() should have been called
+}
+
+std::shared_ptr<Texture> TextureStreamer::Request(const std::string& path, const char* texType,
+	GLuint slot, GLenum filter) {
+	auto texture = std::make_shared<Texture>(texType, slot);
+	auto job = std::make_shared<Job>();
+	job->target = texture;
+	job->path = path;
+	job->filter = filter;
+	job->format = TextureCompressor::FormatForRole(texType);
+	job->compress = compressTextures && TextureCompressor::Supported(job->format);
+	submit(job);
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureStreamer::Request(const unsigned char* bytes, size_t size,
+	const char* texType, GLuint slot, GLenum filter) {
+	auto texture = std::make_shared<Texture>(texType, slot);
+	auto job = std::make_shared<Job>();
+	job->target = texture;
+	// the source may be a mapping or importer memory that goes away
+	job->bytes.assign(bytes, bytes + size);
+	job->filter = filter;
+	job->format = TextureCompressor::FormatForRole(texType);
+	job->compress = compressTextures && TextureCompressor::Supported(job->format);
+	submit(job);
+	return texture;
+}
+
+void TextureStreamer::submit(const std::shared_ptr<Job>& job) {
+	pending++;
+	ThreadPool::Shared().Submit([this, job]() {
+		auto start = std::chrono::steady_clock::now();
+		if (job->compress) {
+			transcode(*job);
+		}
+		else {
+			bool ok = job->bytes.empty()
+				? Texture::Decode(job->path.c_str(), job->image)
+				: Texture::Decode(job->bytes.data(), job->bytes.size(), job->image);
+			if (!ok) std::cerr << "Failed to load texture: " << job->path << std::endl;
+		}
+		auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		decodeMicros += micros;
+		// compressed source not needed anymore
+		job->bytes.clear();
+		job->bytes.shrink_to_fit();
+
+		std::lock_guard<std::mutex> lock(readyMutex);
+		readyJobs.push_back(job);
+	});
+}
+
+void TextureStreamer::transcode(Job& job) {
+	// the cache is keyed by the source file content, so read it whole first
+	if (job.bytes.empty() && !readFileBytes(job.path, job.bytes)) {
+		std::cerr << "Failed to load texture: " << job.path << std::endl;
+		return;
+	}
+	uint64_t hash = hashBytes(job.bytes.data(), job.bytes.size());
+	if (KtxCache::Load(hash, job.format, job.compressed)) {
+		ktxHits++;
+		return;
+	}
+	ktxMisses++;
+
+	ImageData image;
+	if (!Texture::Decode(job.bytes.data(), job.bytes.size(), image)) {
+		std::cerr << "Failed to load texture: " << job.path << std::endl;
+		return;
+	}
+	// blocks are spread over the pool, this worker helps with its own image
+	job.compressed = TextureCompressor::Compress(image, job.format);
+	KtxCache::Save(hash, job.compressed);
+}
+
+double TextureStreamer::decodeMs() const {
+	return decodeMicros.load() / 1000.0;
+}
+
+// -------------------- Render thread --------------------
+
+void TextureStreamer::initRing() {
+	glGenBuffers(1, &pbo);
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	if (GLExt::hasBufferStorage) {
+		// map once, keep the pointer for the lifetime of the ring
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, RING_SIZE, nullptr, flags);
+		mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, RING_SIZE, flags));
+	}
+	else {
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, RING_SIZE, nullptr, GL_STREAM_DRAW);
+	}
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool TextureStreamer::allocate(size_t size, size_t& offset) {
+	// keep regions aligned for fast copies
+	size = (size + 255) & ~size_t(255);
+	offset = head;
+	if (offset + size > RING_SIZE) offset = 0; // wrap
+
+	// recycle regions the GPU has finished with, oldest first
+	while (!inFlight.empty()) {
+		Region& r = inFlight.front();
+		bool overlaps = r.offset < offset + size && offset < r.offset + r.size;
+		GLenum status = glClientWaitSync(r.fence, 0, 0);
+		bool done = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+		if (!done) {
+			// still in use: only a problem if we need that memory
+			if (overlaps) return false;
+			break;
+		}
+		glDeleteSync(r.fence);
+		inFlight.pop_front();
+	}
+	// a younger region may still sit in the way after a wrap
+	for (const Region& r : inFlight) {
+		if (r.offset < offset + size && offset < r.offset + r.size) return false;
+	}
+	head = offset + size;
+	return true;
+}
+
+bool TextureStreamer::upload(Job& job) {
+	std::shared_ptr<Texture> texture = job.target.lock();
+	// nobody uses it anymore
+	if (!texture) return true;
+	if (job.compressed.valid()) {
+		// blocks are a fraction of the raw size, upload straight from client memory
+		texture->SetCompressed(job.compressed, job.filter);
+		uploadedCount++;
+		return true;
+	}
+	// decode failed
+	if (!job.image.valid()) return true;
+
+	const ImageData& img = job.image;
+	size_t size = img.pixels.size();
+	if (size > RING_SIZE) {
+		// too big for the ring: upload from client memory
+		texture->SetImage(img.width, img.height, img.channels, GL_UNSIGNED_BYTE, img.pixels.data(), job.filter);
+		uploadedCount++;
+		return true;
+	}
+	// GPU still reading the next region: try again next frame
+	size_t offset = 0;
+	if (!allocate(size, offset)) return false;
+
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	if (mapped) {
+		std::memcpy(mapped + offset, img.pixels.data(), size);
+	}
+	else {
+		// fences already guarantee the range is free, no need for the driver to sync
+		void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		std::memcpy(dst, img.pixels.data(), size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	// data pointer is an offset into the PBO
+	texture->SetImage(img.width, img.height, img.channels, GL_UNSIGNED_BYTE,
+		reinterpret_cast<const void*>(offset), job.filter, pbo);
+
+	inFlight.push_back({ offset, (size + 255) & ~size_t(255), glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+	uploadedCount++;
+	return true;
+}
+
+void TextureStreamer::Update(double budgetMs) {
+	if (!pbo) initRing();
+	using clock = std::chrono::steady_clock;
+	clock::time_point start = clock::now();
+
+	for (;;) {
+		std::shared_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			if (readyJobs.empty()) return;
+			job = readyJobs.front();
+		}
+
+		// keep the job queued while the ring is busy
+		if (!upload(*job)) return;
+
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			readyJobs.pop_front();
+		}
+		pending--;
+
+		double elapsedMs = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		if (elapsedMs >= budgetMs) return;
+	}
+}
+
+void TextureStreamer::Flush() {
+	while (pending.load() > 0) {
+		ThreadPool::Shared().WaitIdle();
+		Update(1e9);
+		// ring full: let the GPU catch up
+		if (pending.load() > 0) glFinish();
+	}
+}
+
+void TextureStreamer::Shutdown() {
+	for (Region& r : inFlight) glDeleteSync(r.fence);
+	inFlight.clear();
+	if (pbo) {
+		if (mapped) {
+			GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		GLState::ForgetBuffer(pbo);
+		glDeleteBuffers(1, &pbo);
+	}
+	pbo = 0;
+	mapped = nullptr;
+}
+
+// -------------------- Benchmark --------------------
+
+double TextureStreamer::BenchmarkDecode(const std::vector<std::string>& paths, unsigned int threadCount) {
+	using clock = std::chrono::steady_clock;
+	clock::time_point start = clock::now();
+	{
+		ThreadPool pool(threadCount);
+		for (const std::string& path : paths) {
+			pool.Submit([path]() {
+				ImageData image;
+				if (!Texture::Decode(path.c_str(), image))
+					std::cerr << "Failed to load texture: " << path << std::endl;
+			});
+		}
+		pool.WaitIdle();
+	}
+	double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	std::cout << "[TextureStreamer] decoded " << paths.size() << " images on "
+		<< threadCount << " threads in " << ms << " ms\n";
+	return ms;
+}
@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+	if (threadCount == 0) {
+		unsigned int hw = std::thread::hardware_concurrency();
+		threadCount = hw > 1 ? hw - 1 : 1;
+	}
+	for (unsigned int i = 0; i < threadCount; ++i) {
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobReady.notify_all();
+	for (std::thread& t : workers) t.join();
+}
+
+void ThreadPool::Submit(std::function<void()> job) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push(std::move(job));
+	}
+	jobReady.notify_one();
+}
+
+void ThreadPool::WaitIdle() {
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return jobs.empty() && running == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+	if (count == 0) return;
+
+	struct State {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> done{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	auto state = std::make_shared<State>();
+
+	// claims items until none are left (late helpers return without touching fn)
+	auto work = [state, count, &fn]() {
+		for (;;) {
+			size_t i = state->next++;
+			if (i >= count) return;
+			fn(i);
+			if (++state->done == count) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = std::min<size_t>(workers.size(), count - 1);
+	for (size_t i = 0; i < helpers; ++i) Submit(work);
+	work();
+
+	// only items already being processed by other threads can be left
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&] { return state->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::Shared() {
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::workerLoop() {
+	for (;;) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+			// finish queued work before shutting down
+			if (stopping && jobs.empty()) return;
+			job = std::move(jobs.front());
+			jobs.pop();
+			running++;
+		}
+		job();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running--;
+			if (jobs.empty() && running == 0) idle.notify_all();
+		}
+	}
+}
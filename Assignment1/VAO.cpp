@@ -1,5 +1,6 @@
 #include"VAO.h"
 #include"VBO.h"
+#include"GLState.h"
 
 // Constructor that generates a VAO ID
 VAO::VAO() {
@@ -8,23 +9,43 @@ VAO::VAO() {
 
 // Links a VBO Attribute to the VAO using a certain layout for float attributes
 void VAO::LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLsizei stride, const void* offset) {
+	LinkVBO(VBO, layout, numComponents, GL_FLOAT, GL_FALSE, stride, offset);
+}
+
+// Links a VBO Attribute of any type, converted to float by the GPU
+void VAO::LinkVBO(VBO& VBO, GLuint layout, GLint numComponents, GLenum type, GLboolean normalized,
+	GLsizei stride, const void* offset) {
 	VBO.Bind();
-	glVertexAttribPointer(layout, numComponents, GL_FLOAT, GL_FALSE, stride, offset);
+	glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
 	glEnableVertexAttribArray(layout);
 	VBO.Unbind();
 }
 
+// Links an integer VBO Attribute (ivec/uvec in the shader)
+void VAO::LinkVBOI(VBO& VBO, GLuint layout, GLint numComponents, GLenum type, GLsizei stride, const void* offset) {
+	VBO.Bind();
+	glVertexAttribIPointer(layout, numComponents, type, stride, offset);
+	glEnableVertexAttribArray(layout);
+	VBO.Unbind();
+}
+
+// Makes an attribute per-instance
+void VAO::SetDivisor(GLuint layout, GLuint divisor) {
+	glVertexAttribDivisor(layout, divisor);
+}
+
 // Binds the VAO
 void VAO::Bind() {
-	glBindVertexArray(ID);
+	GLState::BindVertexArray(ID);
 }
 
 // Unbinds the VAO
 void VAO::Unbind() {
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 // Deletes the VAO
 void VAO::Delete() {
+	GLState::ForgetVertexArray(ID);
 	glDeleteVertexArrays(1, &ID);
 }
\ No newline at end of file
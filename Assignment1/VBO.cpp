@@ -1,23 +1,49 @@
 #include"VBO.h"
+#include"GLState.h"
+#include"GLExt.h"
 
 // Constructor that generates a Vertex Buffer Object and links it to vertices
-VBO::VBO(const std::vector<Vertex>& vertices) {
+VBO::VBO(const std::vector<Vertex>& vertices)
+	: VBO(vertices.data(), vertices.size()) {
+}
+
+// Constructor that uploads vertices straight from memory
+VBO::VBO(const Vertex* vertices, size_t count)
+	: VBO(static_cast<const void*>(vertices), count * sizeof(Vertex)) {
+}
+
+// Constructor for raw vertex data (packed layouts, several streams)
+VBO::VBO(const void* data, size_t size) {
 	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+}
+
+// Constructor for immutable storage (e.g. persistently mapped)
+VBO::VBO(size_t size, GLbitfield storageFlags) {
+	glGenBuffers(1, &ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, storageFlags);
+}
+
+// Overwrites part of the buffer
+void VBO::Update(size_t offset, const void* data, size_t size) {
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 }
 
 // Binds the VBO
 void VBO::Bind() {
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, ID);
 }
 
 // Unbinds the VBO
 void VBO::Unbind() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 // Deletes the VBO
 void VBO::Delete() {
+	GLState::ForgetBuffer(ID);
 	glDeleteBuffers(1, &ID);
 }
\ No newline at end of file
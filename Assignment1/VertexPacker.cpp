@@ -0,0 +1,133 @@
+#include "VertexPacker.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+	int16_t toSnorm16(float v) {
+		v = std::max(-1.0f, std::min(1.0f, v));
+		return static_cast<int16_t>(std::lround(v * 32767.0f));
+	}
+
+	float fromSnorm16(int16_t v) {
+		return std::max(-1.0f, v / 32767.0f);
+	}
+
+	uint8_t toUnorm8(float v) {
+		v = std::max(0.0f, std::min(1.0f, v));
+		return static_cast<uint8_t>(std::lround(v * 255.0f));
+	}
+}
+
+glm::vec3 VertexPacker::PositionScale(const glm::vec3& aabbMin, const glm::vec3& aabbMax) {
+	// the attribute is normalized, so 65535 already arrives as 1.0
+	return aabbMax - aabbMin;
+}
+
+void VertexPacker::Pack(MeshData& mesh) {
+	glm::vec3 extent = mesh.aabbMax - mesh.aabbMin;
+	// flat axes (e.g. a plane) all quantize to 0
+	glm::vec3 invExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+		extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+		extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+	mesh.packedVertices.resize(mesh.vertices.size());
+	if (mesh.hasColor) mesh.colors.resize(mesh.vertices.size());
+
+	for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+		const Vertex& v = mesh.vertices[i];
+		PackedVertex& p = mesh.packedVertices[i];
+
+		glm::vec3 t = glm::clamp((v.position - mesh.aabbMin) * invExtent, 0.0f, 1.0f);
+		for (int c = 0; c < 3; ++c)
+			p.position[c] = static_cast<uint16_t>(std::lround(t[c] * 65535.0f));
+		p.padding = 0;
+
+		OctEncode(v.normal, p.normal);
+		p.texUV[0] = FloatToHalf(v.texUV.x);
+		p.texUV[1] = FloatToHalf(v.texUV.y);
+
+		if (mesh.hasColor) {
+			mesh.colors[i] = toUnorm8(v.color.r) | (toUnorm8(v.color.g) << 8)
+				| (toUnorm8(v.color.b) << 16) | (255u << 24);
+		}
+	}
+
+	// the float copy is no longer needed
+	std::vector<Vertex>().swap(mesh.vertices);
+	mesh.format = VertexFormat::Packed;
+}
+
+uint16_t VertexPacker::FloatToHalf(float value) {
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(f));
+	uint32_t sign = (f >> 16) & 0x8000u;
+	uint32_t rawExp = (f >> 23) & 0xFFu;
+	uint32_t mant = f & 0x7FFFFFu;
+
+	// inf / nan
+	if (rawExp == 0xFF) return static_cast<uint16_t>(sign | 0x7C00u | (mant ? 0x200u : 0u));
+	int exp = static_cast<int>(rawExp) - 127 + 15;
+	// too large: inf
+	if (exp >= 31) return static_cast<uint16_t>(sign | 0x7C00u);
+	if (exp <= 0) {
+		// subnormal half (or zero)
+		if (exp < -10) return static_cast<uint16_t>(sign);
+		mant |= 0x800000u;
+		uint32_t shift = static_cast<uint32_t>(14 - exp);
+		uint32_t h = mant >> shift;
+		uint32_t rem = mant & ((1u << shift) - 1u);
+		uint32_t halfway = 1u << (shift - 1u);
+		if (rem > halfway || (rem == halfway && (h & 1u))) h++;
+		return static_cast<uint16_t>(sign | h);
+	}
+	uint32_t h = (static_cast<uint32_t>(exp) << 10) | (mant >> 13);
+	uint32_t rem = mant & 0x1FFFu;
+	// a carry into the exponent is still the correctly rounded value
+	if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) h++;
+	return static_cast<uint16_t>(sign | h);
+}
+
+float VertexPacker::HalfToFloat(uint16_t half) {
+	uint32_t sign = (half & 0x8000u) << 16;
+	uint32_t exp = (half >> 10) & 0x1Fu;
+	uint32_t mant = half & 0x3FFu;
+	float value;
+	if (exp == 0) {
+		// zero / subnormal: mant * 2^-24
+		value = std::ldexp(static_cast<float>(mant), -24);
+		return sign ? -value : value;
+	}
+	uint32_t f = sign | (exp == 31 ? 0x7F800000u | (mant << 13) : ((exp + 112u) << 23) | (mant << 13));
+	std::memcpy(&value, &f, sizeof(value));
+	return value;
+}
+
+void VertexPacker::OctEncode(const glm::vec3& normal, int16_t out[2]) {
+	float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (l1 <= 0.0f) {
+		// missing normal: decodes to +Z rather than NaN
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+	// project onto the octahedron, fold the lower half over the diagonals
+	glm::vec2 p(normal.x / l1, normal.y / l1);
+	if (normal.z < 0.0f) {
+		glm::vec2 folded((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+		p = folded;
+	}
+	out[0] = toSnorm16(p.x);
+	out[1] = toSnorm16(p.y);
+}
+
+glm::vec3 VertexPacker::OctDecode(const int16_t in[2]) {
+	// same math as octDecode() in scene.vert
+	glm::vec3 n(fromSnorm16(in[0]), fromSnorm16(in[1]), 0.0f);
+	n.z = 1.0f - std::abs(n.x) - std::abs(n.y);
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}